@@ -0,0 +1,138 @@
+// bench_contention.c
+// Write throughput of hinotetsu3 under shard contention: threads SET and
+// DELETE a few hot keys, so they queue on the same shard locks. Runs each
+// thread count with the plain shard rwlock and with flat combining
+// (HinotetsuOptions.combining).
+// Links the engine directly; build from benchmark/ (execute_bench.sh does):
+// gcc -O2 -pthread -I.. bench_contention.c ../hinotetsu3.c -o bench_contention
+//
+// Usage:
+//   ./bench_contention --threads 1,2,4,8 --ops 500000 --keys 8
+//   ./bench_contention --threads 16 --keys 1 --value 512 --delete-pct 0
+
+#include "hinotetsu3.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_THREADS 256
+
+typedef struct {
+  Hinotetsu* db;
+  int thread_id;
+  int ops;
+  int keys;
+  int delete_pct;
+  size_t vlen;
+  pthread_barrier_t* start;
+} Worker;
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void* worker(void* arg) {
+  Worker* w = (Worker*)arg;
+  char key[32];
+  char* value = (char*)malloc(w->vlen ? w->vlen : 1);
+  if (!value) return NULL;
+  memset(value, 'x', w->vlen);
+
+  unsigned seed = (unsigned)w->thread_id * 2654435761u + 1u;
+  pthread_barrier_wait(w->start);
+  for (int i = 0; i < w->ops; i++) {
+    int k = rand_r(&seed) % w->keys;
+    int klen = snprintf(key, sizeof(key), "hot:%d", k);
+    if (rand_r(&seed) % 100 < w->delete_pct) {
+      hinotetsu_delete(w->db, key, (size_t)klen);
+    } else {
+      hinotetsu_set(w->db, key, (size_t)klen, value, w->vlen, 0);
+    }
+  }
+  free(value);
+  return NULL;
+}
+
+// One run; returns writes per second and the share run by another writer
+static double run(int threads, int combining, int ops, int keys, size_t vlen,
+                  int delete_pct, double* combined) {
+  HinotetsuOptions opt;
+  hinotetsu_options_init(&opt);
+  opt.combining = combining;
+  Hinotetsu* db = hinotetsu_open_ex(&opt);
+  if (!db) {
+    fprintf(stderr, "ERROR: hinotetsu_open_ex failed\n");
+    exit(1);
+  }
+
+  pthread_t tids[MAX_THREADS];
+  Worker ws[MAX_THREADS];
+  pthread_barrier_t start;
+  pthread_barrier_init(&start, NULL, (unsigned)threads + 1u);
+  for (int t = 0; t < threads; t++) {
+    ws[t] = (Worker){ db, t, ops, keys, delete_pct, vlen, &start };
+    pthread_create(&tids[t], NULL, worker, &ws[t]);
+  }
+  pthread_barrier_wait(&start);
+  double t0 = now_sec();
+  for (int t = 0; t < threads; t++) pthread_join(tids[t], NULL);
+  double elapsed = now_sec() - t0;
+  pthread_barrier_destroy(&start);
+
+  HinotetsuStats st;
+  hinotetsu_stats(db, &st);
+  hinotetsu_close(db);
+
+  double total = (double)threads * ops;
+  *combined = total > 0 ? (double)st.combined / total : 0.0;
+  return elapsed > 0 ? total / elapsed : 0.0;
+}
+
+static void usage(const char* prog) {
+  fprintf(stderr,
+          "Usage: %s [--threads 1,2,4,8] [--ops N] [--keys N] [--value BYTES]"
+          " [--delete-pct P]\n", prog);
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  const char* thread_list = "1,2,4,8";
+  int ops = 500000;  // per thread
+  int keys = 8;
+  size_t vlen = 64;
+  int delete_pct = 10;
+
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 >= argc) usage(argv[0]);
+    if (!strcmp(argv[i], "--threads")) thread_list = argv[++i];
+    else if (!strcmp(argv[i], "--ops")) ops = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--keys")) keys = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--value")) vlen = (size_t)atol(argv[++i]);
+    else if (!strcmp(argv[i], "--delete-pct")) delete_pct = atoi(argv[++i]);
+    else usage(argv[0]);
+  }
+  if (ops <= 0 || keys <= 0 || delete_pct < 0 || delete_pct > 100) usage(argv[0]);
+
+  printf("%d ops per thread, %d hot keys, %zu-byte values, %d%% deletes\n",
+         ops, keys, vlen, delete_pct);
+  printf("%8s %14s %14s %9s %10s\n", "threads", "rwlock ops/s", "combine ops/s",
+         "speedup", "combined");
+
+  char* list = strdup(thread_list);
+  for (char* tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+    int threads = atoi(tok);
+    if (threads <= 0 || threads > MAX_THREADS) usage(argv[0]);
+    double unused, combined;
+    double plain = run(threads, 0, ops, keys, vlen, delete_pct, &unused);
+    double fc = run(threads, 1, ops, keys, vlen, delete_pct, &combined);
+    printf("%8d %14.0f %14.0f %8.2fx %9.1f%%\n", threads, plain, fc,
+           plain > 0 ? fc / plain : 0.0, combined * 100.0);
+  }
+  free(list);
+  return 0;
+}
@@ -11,4 +11,10 @@ echo "=== memcached ==="
 echo ""
 echo "=== Redis ==="
 ./bench_pipeline --host 127.0.0.1 --port 6379 --ops 200000 --pipeline 128 --redis
-./bench_pipeline --host 127.0.0.1 --port 6379 --ops 2000000 --pipeline 128 --redis
\ No newline at end of file
+./bench_pipeline --host 127.0.0.1 --port 6379 --ops 2000000 --pipeline 128 --redis
+
+# In-process write contention (no server): plain shard locks vs flat combining
+echo ""
+echo "=== Hinotetsu shard contention ==="
+gcc -O2 -pthread -I.. bench_contention.c ../hinotetsu3.c -o bench_contention
+./bench_contention --threads 1,2,4,8 --ops 500000 --keys 8
@@ -1,656 +1,3550 @@
 // hinotetsu3.c
 // Ultra-low-latency sharded KV store with incremental resize
 // Key features:
-// - Incremental hash table resize (migrate HINOTETSU_MIGRATE_BATCH entries per op)
+// - Incremental hash table resize (migrate HINOTETSU_MIGRATE_BATCH entries per op):
+//   grow, shrink after deletes/expiry, or same-size rehash to purge tombstones
+// - Linear-probe, SIMD control-byte (Swiss), Robin Hood or bucketized
+//   cuckoo shard tables (HINOTETSU_TABLE)
+// - wyhash, CRC32C or FNV-1a key hash (HINOTETSU_HASH), cached in each entry
 // - Pre-warmed slab allocator with eager page allocation
 // - Memory pre-touch on startup to avoid page faults
+// - Single-chunk entries (header + key + small value, like memcached's item)
+//   recycled on delete, overwrite and expiry; when a slab class is full the
+//   eviction policy (HINOTETSU_EVICTION) reclaims entries of that class
+// - Active TTL expiry through a per-shard hierarchical timing wheel, turned a
+//   little on every write and by hinotetsu_expire() / the maintenance thread
+// - Cached millisecond engine clock (no time() call per operation) and
+//   millisecond TTLs (hinotetsu_set_ms)
 // License: BUSL (Business Source License)
 #include "hinotetsu3.h"
 
 #include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 #ifdef __linux__
+#include <stdio.h>
 #include <sys/mman.h>
 #define USE_MMAP_ALLOC 1
 #else
 #define USE_MMAP_ALLOC 0
 #endif
 
-#define LOAD_FACTOR_NUM 7u
-#define LOAD_FACTOR_DEN 10u
 #define TOMBSTONE_PTR   ((Entry*)1)
-#define VALUE_CLASS_BUMP 255u
+#define VALUE_CLASS_LARGE 255u  // extent from the large-object allocator
+#define VALUE_INLINE      254u
+#define VALUE_CLASS_NONE  253u  // allocation that no eviction can satisfy
+
+#if HINOTETSU_EVICTION == HINOTETSU_EVICT_LRU
+// LRU reorders the queue on every hit, so readers need exclusive access
+#define SHARD_READ_LOCK(s) pthread_rwlock_wrlock(&(s)->lock)
+#else
+#define SHARD_READ_LOCK(s) pthread_rwlock_rdlock(&(s)->lock)
+#endif
+
+#if HINOTETSU_LOCKFREE_READS && HINOTETSU_EVICTION == HINOTETSU_EVICT_LRU
+#error "HINOTETSU_LOCKFREE_READS needs an eviction policy whose hits leave the queue alone"
+#endif
+
+// Table slots, control bytes and table pointers that lock-free readers
+// probe: published with release stores, read with acquire loads
+#if HINOTETSU_LOCKFREE_READS
+#define SHARED_LOAD(p)     __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define SHARED_STORE(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#else
+#define SHARED_LOAD(p)     (p)
+#define SHARED_STORE(p, v) ((p) = (v))
+#endif
 
 // --------- slab helpers ----------
 typedef struct SlabNode {
   struct SlabNode* next;
 } SlabNode;
 
-static inline uint32_t ceil_pow2_u32(uint32_t x) {
-  if (x <= 1) return 1;
-  x--;
-  x |= x >> 1;
-  x |= x >> 2;
-  x |= x >> 4;
-  x |= x >> 8;
-  x |= x >> 16;
-  return x + 1;
-}
+// Slab classes are computed at open: chunk sizes start at
+// 1 << HINOTETSU_SLAB_MIN_SHIFT and grow by HINOTETSU_SLAB_GROWTH_FACTOR
+// (8-byte aligned) up to 1 << HINOTETSU_SLAB_MAX_SHIFT, like memcached's -f.
+#if HINOTETSU_SLAB_MAX_CLASSES > 253
+#error "HINOTETSU_SLAB_MAX_CLASSES must leave room for the VALUE_* markers"
+#endif
+
+#define SLAB_MIN_CHUNK   ((size_t)1u << HINOTETSU_SLAB_MIN_SHIFT)
+#define SLAB_MAX_CHUNK   ((size_t)1u << HINOTETSU_SLAB_MAX_SHIFT)
+#define SLAB_LOOKUP_SIZE (SLAB_MAX_CHUNK / 8u + 1u)
+
+// Every slab page has the same size so a page can change class
+#define SLAB_PAGE_BYTES \
+  ((((size_t)HINOTETSU_SLAB_PAGE_SIZE > SLAB_MAX_CHUNK * 8u ? \
+     (size_t)HINOTETSU_SLAB_PAGE_SIZE : SLAB_MAX_CHUNK * 8u) + 7u) & ~(size_t)7u)
+#define SLAB_PAGE_MAX_CHUNKS (SLAB_PAGE_BYTES / SLAB_MIN_CHUNK)
+#define SLAB_PAGE_NONE       UINT32_MAX
+
+typedef struct SlabClasses {
+  uint32_t count;
+  uint32_t size[HINOTETSU_SLAB_MAX_CLASSES];
+  uint8_t lookup[SLAB_LOOKUP_SIZE];  // (n + 7) / 8 -> smallest class >= n
+} SlabClasses;
+
+static void slab_classes_init(SlabClasses* c, double factor) {
+  memset(c, 0, sizeof(*c));
+  size_t size = SLAB_MIN_CHUNK;
+  while (size < SLAB_MAX_CHUNK && c->count < HINOTETSU_SLAB_MAX_CLASSES - 1u) {
+    c->size[c->count++] = (uint32_t)size;
+    size_t next = ((size_t)((double)size * factor) + 7u) & ~(size_t)7u;
+    size = next > size ? next : size + 8u;
+  }
+  c->size[c->count++] = (uint32_t)SLAB_MAX_CHUNK;
 
-static inline uint8_t class_for_size(size_t n) {
-  uint32_t min_s = HINOTETSU_SLAB_MIN_SHIFT;
-  uint32_t max_s = HINOTETSU_SLAB_MAX_SHIFT;
-  if (n == 0) n = 1;
-  uint32_t need = (uint32_t)n;
-  uint32_t cap = ceil_pow2_u32(need);
-  uint8_t shift = 0;
-  while ((1u << shift) < cap) shift++;
-  if (shift < min_s) shift = (uint8_t)min_s;
-  if (shift > max_s) return VALUE_CLASS_BUMP;
-  return shift;
+  uint32_t cls = 0;
+  for (size_t i = 0; i < SLAB_LOOKUP_SIZE; i++) {
+    while (c->size[cls] < i * 8u) cls++;
+    c->lookup[i] = (uint8_t)cls;
+  }
 }
 
-static inline size_t class_size(uint8_t shift) {
-  return (size_t)1u << shift;
+static inline uint8_t class_for_size(const SlabClasses* c, size_t n) {
+  if (n > SLAB_MAX_CHUNK) return VALUE_CLASS_LARGE;
+  return c->lookup[(n + 7u) >> 3];
 }
 
 // -------------------- data structures --------------------
+// An entry is a single slab chunk: header, key bytes, then the value.
+// Values that would push the chunk past the largest slab class are stored
+// out-of-line and data[] holds a pointer to them after the key.
 typedef struct Entry {
-  char* key;
-  char* value;
-  uint32_t klen;
+  struct Entry* prev;  // eviction queue: towards newer entries
+  struct Entry* next;  // eviction queue: towards older entries
+  uint64_t hash;       // key_hash() of the key
+  struct Entry* wnext;    // timing wheel list, entries with a TTL only
+  struct Entry** wpprev;  // link pointing at this entry, NULL if not queued
   uint32_t vlen;
-  uint32_t expire;
-  uint8_t deleted;
-  uint8_t vclass;
+  uint32_t expire;     // deadline, whole seconds (0 = no TTL)
+  uint16_t expire_ms;  // deadline, milliseconds past expire
+  uint16_t klen;
+  uint8_t eclass;      // slab class of this chunk
+  uint8_t vclass;      // class of an out-of-line value, VALUE_INLINE if none
+  uint8_t visited;     // CLOCK/SIEVE reference bit
+  uint8_t refs;        // borrowed references (ENTRY_REFS) | ENTRY_RETIRED
+  char data[];         // key, then value bytes or a char* to them
 } Entry;
 
+// Entries pinned by hinotetsu_get_ref() are not freed when unlinked; they
+// are marked retired and freed under the write lock by the last release.
+// An entry pinned ENTRY_REFS times is copied out instead.
+#define ENTRY_REFS    0x7Fu
+#define ENTRY_RETIRED 0x80u
+
+// Per slab class eviction queue (head = newest, tail = oldest)
+typedef struct EntryQueue {
+  Entry* head;
+  Entry* tail;
+  Entry* hand;   // SIEVE hand, walks from tail towards head
+} EntryQueue;
+
+#define WHEEL_BITS   6u
+#define WHEEL_SLOTS  (1u << WHEEL_BITS)
+#define WHEEL_LEVELS 4u  // 64^4 s (~194 days); longer TTLs wait in overflow
+
+typedef struct TimerWheel {
+  uint32_t now;    // next second to expire (deadlines up to now * 1000 ms)
+  uint32_t items;  // entries on the wheel
+  Entry* slot[WHEEL_LEVELS][WHEEL_SLOTS];
+  Entry* overflow;
+} TimerWheel;
+
+// Engine clock in Unix milliseconds. Operations read the cached value while
+// a driver (hinotetsu_clock_set() or the maintenance thread) keeps it fresh
+// and fall back to the system clock otherwise.
+#define CLOCK_DRIVEN_EXTERNAL 1u
+#define CLOCK_DRIVEN_TICKER   2u
+
+// A line of its own: the ticker writes it every millisecond
+typedef struct EngineClock {
+  uint64_t now_ms;
+  uint32_t driven;  // CLOCK_DRIVEN_* bits
+} __attribute__((aligned(64))) EngineClock;
+
+// Per-thread reader state. Readers share the shard lock (or take none), so
+// each thread writes a cache line of its own, one of READER_SLOTS: hit and
+// miss counters summed by the stats calls, and with HINOTETSU_LOCKFREE_READS
+// the epoch it is reading in.
+#define READER_SLOTS 64u
+
+typedef struct ReaderSlot {
+  uint64_t hits;
+  uint64_t misses;
+  uint32_t active[2];  // readers inside an epoch, by its parity
+} __attribute__((aligned(64))) ReaderSlot;
+
+typedef struct Readers {
+  ReaderSlot* slot;  // READER_SLOTS, cache-line aligned
+  uint64_t epoch;    // reclamation epoch (HINOTETSU_LOCKFREE_READS)
+} __attribute__((aligned(64))) Readers;
+
+// Flat combining (HinotetsuOptions.combining): a writer that finds its shard
+// locked publishes the SET or DELETE in its slot, one of READER_SLOTS per
+// shard, and waits; the lock holder runs every published op before letting
+// go. key and value point into the waiting writer's buffers.
+#define FC_FREE 0u  // state: free to claim
+#define FC_BUSY 1u  // claimed, or published and pending
+#define FC_DONE 2u  // ret is set
+#define FC_SET    0
+#define FC_DELETE 1
+#define FC_PASSES 4u  // rounds of newly published ops one combiner runs
+
+typedef struct FcSlot {
+  uint32_t state;
+  int op;
+  int ret;
+  uint64_t hash;
+  const char* key;
+  size_t klen;
+  const char* value;
+  size_t vlen;
+  uint64_t ttl_ms;
+} __attribute__((aligned(64))) FcSlot;
+
+typedef struct Table Table;
+
+// Memory obtained from mapping_create
+typedef struct Mapping {
+  uint8_t* base;
+  size_t bytes;   // length mapped; whole huge pages for MAPPING_HUGETLB
+  uint32_t kind;  // MAPPING_*
+} Mapping;
+
+// Per-shard accounting of one slab class
+typedef struct SlabClassState {
+  uint32_t pages;
+  uint32_t chunks;     // carved from pages
+  uint32_t free;       // on the freelist
+  uint64_t requested;  // bytes asked for by the chunks in use
+  uint32_t starved;    // allocations that found the class and the pool dry
+} SlabClassState;
+
+// Slab page metadata, indexed by page-aligned pool offset
+#define PAGE_UNUSED 0u  // not carved yet
+#define PAGE_CLASS  1u  // chunks of cls
+#define PAGE_FREE   2u  // evacuated, on the shard's free page list
+#define PAGE_LARGE  3u  // part of a large-object span
+
+typedef struct SlabPage {
+  uint8_t kind;    // PAGE_*
+  uint8_t cls;
+  uint16_t pinned; // entries with references, the mover leaves the page alone
+  uint32_t used;   // chunks handed out
+  uint32_t values; // of which out-of-line values
+  uint32_t next;   // free page list links
+  uint32_t prev;
+} SlabPage;
+
+// Large-object allocator. Values above the largest slab class live in
+// extents carved from spans of whole slab pages. Each extent carries its
+// size (with LARGE_USED) in a header and a footer, so a freed extent merges
+// with free neighbours in O(1); a span starts and ends with a used tag so
+// merging stops at its edges. Free extents sit on power-of-two bins, and a
+// span that becomes entirely free returns its pages to the free page list.
+#define LARGE_USED        ((size_t)1u)
+#define LARGE_TAG         sizeof(size_t)
+#define LARGE_OVERHEAD    (2u * LARGE_TAG)  // header + footer
+#define LARGE_MIN_EXTENT  64u
+#define LARGE_BIN_SHIFT   5u                // bin 0 holds extents from 32B
+#define LARGE_BINS        32u
+
+typedef struct LargeFree {
+  size_t tag;
+  struct LargeFree* next;
+  struct LargeFree* prev;
+} LargeFree;
+
+// The pool is one arena of HINOTETSU_ARENA_CHUNK-byte chunks. Shards lease
+// chunks as they need pages and hand a chunk back once all its pages are
+// free again, so the memory limit applies to the instance as a whole.
+// Chunk links and owners change under the arena mutex (and the owning
+// shard's lock); page metadata and free page counts belong to the shard
+// holding the chunk.
+#define ARENA_NONE UINT32_MAX
+#define ARENA_FREE UINT16_MAX  // owner of a chunk that is not leased
+
+typedef struct ArenaChunk {
+  uint32_t next;        // arena free list, or the owner's chunk list
+  uint32_t prev;
+  uint16_t owner;       // shard index, ARENA_FREE if not leased
+  uint16_t free_pages;  // pages on the owner's free page list
+} ArenaChunk;
+
+typedef struct Arena {
+  pthread_mutex_t mu;
+  Mapping mem;
+  int elastic;          // chunks fault in on use and go back to the OS when idle
+  uint64_t released;    // chunk bytes returned to the OS
+  uint8_t* base;        // mem.base
+  size_t bytes;         // chunk_count whole chunks, at most mem.bytes
+  uint32_t pages_per_chunk;
+  uint32_t chunk_count;
+  uint32_t free_chunks;
+  uint32_t free_head;
+  ArenaChunk* chunks;
+  SlabPage* pages;      // metadata of every page in the arena
+
+  // Pre-fault threads claim chunks in order (arena_prefault)
+  uint32_t prefault_next;   // next chunk to claim
+  uint32_t prefault_done;   // chunks faulted in
+  int prefault_stop;
+  uint32_t prefault_nthreads;
+  pthread_t prefault_thread[HINOTETSU_PREFAULT_MAX_THREADS];
+  uint64_t prefault_start_ns;
+  uint64_t prefault_ns;     // time to fault in every chunk, 0 until done
+} Arena;
+
+// Laid out by who writes what. The first cache line is read on every
+// access and written only at a resize; the second is written by readers too
+// (the lock, pinned counts); the combining mask by waiting writers; the rest
+// only under the write lock. Shards are cache-line aligned, so neighbours
+// share no line either.
 typedef struct Shard {
-  pthread_rwlock_t lock;
-
-  // Bump allocator
-  uint8_t* pool;
-  size_t pool_size;
-  size_t pool_pos;
-
-  // Current hash table
-  Entry** tab;
-  uint32_t cap;
-  uint32_t used;
+  const EngineClock* clock;
+  const SlabClasses* classes;
+  Arena* arena;
+  Readers* readers;
+  FcSlot* fc;         // flat combining slots, NULL unless enabled
+  Table* tab;         // current hash table
+  Table* new_tab;     // NULL if not resizing
+  uint16_t id;
+  int huge_tables;    // map tables of a huge page or more on huge pages
+
+  pthread_rwlock_t lock __attribute__((aligned(64)));
+  // Lock-free reads: seq is odd while a writer holds the lock, so a reader
+  // can tell whether a miss raced a write
+  uint32_t seq;
+  uint32_t pinned;  // entries with references, updated under the read lock
+
+  uint64_t fc_pending __attribute__((aligned(64)));  // a bit per slot with an op pending
+
+  // Chunks leased from the arena, carved page by page for slab classes and
+  // large-object spans
+  uint32_t chunk_head __attribute__((aligned(64)));  // chunks held, linked through ArenaChunk
+  uint32_t chunks;
+  uint32_t spare_chunk;  // one entirely free chunk kept back from the arena
+  uint32_t evict_peer;   // next shard asked for a chunk once the arena is spent
   uint32_t count;
 
-  // Incremental resize state
-  Entry** new_tab;       // NULL if not resizing
-  uint32_t new_cap;
-  uint32_t new_used;
+  // Incremental resize state, advanced by writers only so that readers
+  // never modify the tables they search
   uint32_t migrate_pos;  // next index to migrate from old table
 
-  // Slab freelists
-  SlabNode* freelist[32];
+  // Slab freelists and accounting, indexed by class
+  SlabNode* freelist[HINOTETSU_SLAB_MAX_CLASSES];
+  SlabClassState slab[HINOTETSU_SLAB_MAX_CLASSES];
+
+  // Free pages of the leased chunks, reassigned between classes by the
+  // slab mover
+  uint32_t free_page;  // head of the free page list, SLAB_PAGE_NONE if empty
+
+  // Large-object extents and the queue of entries whose value is one
+  LargeFree* large_bin[LARGE_BINS];
+  EntryQueue large_queue;
+  uint32_t large_pages;
+  uint32_t large_starved;
+  uint64_t large_items;
+  uint64_t large_bytes;      // extent bytes in use
+  uint64_t large_requested;
+
+  // Eviction queues, indexed like freelist
+  EntryQueue queue[HINOTETSU_SLAB_MAX_CLASSES];
+
+  // Unlinked entries with references, awaiting their last release
+  Entry* retired;
+
+  // Active expiry of entries with a TTL
+  TimerWheel wheel;
+
+  // Entries freed with HINOTETSU_LOCKFREE_READS wait in limbo[i] until the
+  // epoch is two past limbo_epoch[i] and no reader can see them
+  uint32_t limbo_count;
+  int free_now;  // frees skip the limbo; the caller waits out the readers
+  int chunks_held;  // chunks emptied under free_now, idled after the wait
+  Entry* limbo[3];
+  uint64_t limbo_epoch[3];
 
   // Stats
-  size_t hits;
-  size_t misses;
-} Shard;
+  size_t item_bytes;  // slab bytes held by stored entries
+  size_t evictions;
+  size_t reclaimed;
+  size_t combined;  // ops run for another writer
+} __attribute__((aligned(64))) Shard;
 
 struct Hinotetsu {
   Shard shards[HINOTETSU_SHARDS];
   size_t pool_size_total;
+  int huge_pages;
+  uint64_t ready_ns;  // time hinotetsu_open_ex() took
+  size_t huge_page_bytes;  // as of the last hinotetsu_huge_page_scan()
+  Arena arena;
+  EngineClock clock;
+  SlabClasses classes;
+  Readers readers;
+  FcSlot* fc;  // READER_SLOTS per shard with HinotetsuOptions.combining
+
+  // Background expiry (hinotetsu_maintenance_start)
+  pthread_t maint_thread;
+  pthread_mutex_t maint_mu;
+  pthread_cond_t maint_cv;
+  uint32_t maint_interval_ms;
+  int maint_running;
+  int maint_stop;
 };
 
 // -------------------- utils --------------------
-static inline uint32_t now_sec(void) {
-  return (uint32_t)time(NULL);
+static inline uint64_t wall_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static inline uint64_t mono_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t clock_now(const EngineClock* c) {
+  if (__atomic_load_n(&c->driven, __ATOMIC_ACQUIRE)) {
+    return __atomic_load_n(&c->now_ms, __ATOMIC_RELAXED);
+  }
+  return wall_ms();
+}
+
+static inline uint64_t shard_now(const Shard* s) {
+  return clock_now(s->clock);
+}
+
+static uint32_t g_thread_slots;
+static __thread uint32_t tls_thread_slot;  // 1 + slot of this thread, 0 = none yet
+
+// This thread's reader and combining slot. Slots are shared once there are
+// more threads than READER_SLOTS.
+static inline uint32_t thread_slot(void) {
+  uint32_t slot = tls_thread_slot;
+  if (!slot) {
+    slot = __atomic_fetch_add(&g_thread_slots, 1u, __ATOMIC_RELAXED) % READER_SLOTS + 1u;
+    tls_thread_slot = slot;
+  }
+  return slot - 1u;
+}
+
+// Reader slots may be shared, hence atomics
+static inline ReaderSlot* reader_slot(const Readers* r) {
+  return &r->slot[thread_slot()];
+}
+
+static inline void read_hit(const Shard* s) {
+  __atomic_add_fetch(&reader_slot(s->readers)->hits, 1u, __ATOMIC_RELAXED);
+}
+
+static inline void read_miss(const Shard* s) {
+  __atomic_add_fetch(&reader_slot(s->readers)->misses, 1u, __ATOMIC_RELAXED);
+}
+
+// --------- epochs ----------
+// Epoch-based reclamation for HINOTETSU_LOCKFREE_READS. A reader counts
+// itself into its slot under the current epoch for the length of a lookup.
+// Writers advance the epoch from e only once no reader is left in e - 1, so
+// memory unlinked in epoch e is out of every reader's reach at e + 2.
+static inline uint64_t ebr_enter(Readers* r, ReaderSlot* rs) {
+  for (;;) {
+    uint64_t e = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&rs->active[e & 1u], 1u, __ATOMIC_SEQ_CST);
+    // An advance in between may not have seen us: retry in the new epoch
+    if (__atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST) == e) return e;
+    __atomic_sub_fetch(&rs->active[e & 1u], 1u, __ATOMIC_RELEASE);
+  }
+}
+
+static inline void ebr_exit(ReaderSlot* rs, uint64_t e) {
+  __atomic_sub_fetch(&rs->active[e & 1u], 1u, __ATOMIC_RELEASE);
+}
+
+// Returns 0 if readers are still in the previous epoch
+static int ebr_try_advance(Readers* r) {
+  uint64_t e = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+  uint32_t prev = (uint32_t)(e + 1u) & 1u;
+  for (uint32_t i = 0; i < READER_SLOTS; i++) {
+    if (__atomic_load_n(&r->slot[i].active[prev], __ATOMIC_SEQ_CST) != 0) return 0;
+  }
+  // Losing the race means another writer advanced it
+  __atomic_compare_exchange_n(&r->epoch, &e, e + 1u, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  return 1;
+}
+
+static void ebr_wait(Readers* r, uint64_t target) {
+  while (__atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST) < target) {
+    if (!ebr_try_advance(r)) sched_yield();
+  }
+}
+
+// Wait until no reader can still hold anything unlinked before the call
+static inline void shard_grace(Shard* s) {
+  if (!HINOTETSU_LOCKFREE_READS) return;
+  ebr_wait(s->readers, __atomic_load_n(&s->readers->epoch, __ATOMIC_SEQ_CST) + 2u);
+}
+
+// Writers hold the lock with seq odd, so a lock-free reader can tell
+// whether its lookup overlapped a write
+static inline void shard_write_locked(Shard* s) {
+  if (HINOTETSU_LOCKFREE_READS) {
+    __atomic_store_n(&s->seq, s->seq + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+  }
+}
+
+static inline void shard_write_lock(Shard* s) {
+  pthread_rwlock_wrlock(&s->lock);
+  shard_write_locked(s);
 }
 
-static inline int is_expired(const Entry* e, uint32_t now) {
-  return (e->expire != 0 && e->expire <= now);
+static inline int shard_write_trylock(Shard* s) {
+  if (pthread_rwlock_trywrlock(&s->lock) != 0) return 0;
+  shard_write_locked(s);
+  return 1;
 }
 
-static inline uint64_t fnv1a64(const char* key, size_t len) {
+static inline void shard_write_unlock(Shard* s) {
+  if (HINOTETSU_LOCKFREE_READS) __atomic_store_n(&s->seq, s->seq + 1u, __ATOMIC_RELEASE);
+  pthread_rwlock_unlock(&s->lock);
+}
+
+#if HINOTETSU_LOCKFREE_READS
+static __thread uint64_t tls_read_epoch;  // 1 + epoch of the read in progress, 0 = none
+#endif
+
+// Shared access for the copying reads: the read lock, or with
+// HINOTETSU_LOCKFREE_READS just an epoch
+static inline void shard_read_begin(Shard* s) {
+#if HINOTETSU_LOCKFREE_READS
+  tls_read_epoch = ebr_enter(s->readers, reader_slot(s->readers)) + 1u;
+#else
+  SHARD_READ_LOCK(s);
+#endif
+}
+
+static inline void shard_read_end(Shard* s) {
+#if HINOTETSU_LOCKFREE_READS
+  ebr_exit(reader_slot(s->readers), tls_read_epoch - 1u);
+  tls_read_epoch = 0;
+#else
+  pthread_rwlock_unlock(&s->lock);
+#endif
+}
+
+// Wait for the writer that overlapped a lookup. A writer may itself be
+// waiting for the readers of an epoch to leave, so the epoch is dropped
+// for the wait; the caller holds nothing from the lookup by then.
+static void shard_read_wait(Shard* s, uint32_t seq) {
+#if HINOTETSU_LOCKFREE_READS
+  if (tls_read_epoch) {
+    ReaderSlot* rs = reader_slot(s->readers);
+    ebr_exit(rs, tls_read_epoch - 1u);
+    while ((seq & 1u) && __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) == seq) sched_yield();
+    tls_read_epoch = ebr_enter(s->readers, rs) + 1u;
+    return;
+  }
+#endif
+  (void)s;
+  (void)seq;
+  sched_yield();
+}
+
+static inline uint64_t entry_deadline(const Entry* e) {
+  return (uint64_t)e->expire * 1000u + e->expire_ms;
+}
+
+static inline int is_expired(const Entry* e, uint64_t now_ms) {
+  return (e->expire != 0 && entry_deadline(e) <= now_ms);
+}
+
+// Timing wheel second by which the entry is due
+static inline uint32_t entry_expire_tick(const Entry* e) {
+  return e->expire + (e->expire_ms != 0);
+}
+
+// -------------------- key hash --------------------
+// Selected with HINOTETSU_HASH. The result is cached in the entry, so each key
+// is hashed once per operation and never again for resize or erase.
+#if HINOTETSU_HASH == HINOTETSU_HASH_WYHASH
+
+// wyhash (final version 4), public domain, by Wang Yi
+static const uint64_t wy_p[4] = {
+  0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+static inline void wy_mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = (__uint128_t)*a * *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline uint64_t wy_mix(uint64_t a, uint64_t b) {
+  wy_mum(&a, &b);
+  return a ^ b;
+}
+
+static inline uint64_t wy_r8(const uint8_t* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t wy_r4(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t wy_r3(const uint8_t* p, size_t k) {
+  return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
+
+static inline uint64_t key_hash(const char* key, size_t len) {
+  const uint8_t* p = (const uint8_t*)key;
+  uint64_t seed = wy_mix(wy_p[0], wy_p[1]);
+  uint64_t a, b;
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (wy_r4(p) << 32) | wy_r4(p + ((len >> 3) << 2));
+      b = (wy_r4(p + len - 4) << 32) | wy_r4(p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = wy_r3(p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t s1 = seed, s2 = seed;
+      do {
+        seed = wy_mix(wy_r8(p) ^ wy_p[1], wy_r8(p + 8) ^ seed);
+        s1 = wy_mix(wy_r8(p + 16) ^ wy_p[2], wy_r8(p + 24) ^ s1);
+        s2 = wy_mix(wy_r8(p + 32) ^ wy_p[3], wy_r8(p + 40) ^ s2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= s1 ^ s2;
+    }
+    while (i > 16) {
+      seed = wy_mix(wy_r8(p) ^ wy_p[1], wy_r8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = wy_r8(p + i - 16);
+    b = wy_r8(p + i - 8);
+  }
+  a ^= wy_p[1];
+  b ^= seed;
+  wy_mum(&a, &b);
+  return wy_mix(a ^ wy_p[0] ^ len, b ^ wy_p[1]);
+}
+
+#elif HINOTETSU_HASH == HINOTETSU_HASH_CRC32C
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define crc32c_u64(c, v) ((uint32_t)_mm_crc32_u64((c), (v)))
+#define crc32c_u8(c, v)  _mm_crc32_u8((c), (v))
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define crc32c_u64(c, v) __crc32cd((c), (v))
+#define crc32c_u8(c, v)  __crc32cb((c), (v))
+#else
+#error "HINOTETSU_HASH_CRC32C needs SSE4.2 (-msse4.2) or ARMv8 CRC (-march=armv8-a+crc)"
+#endif
+
+// Hardware CRC32C, 8 bytes per instruction. The 32-bit result is spread over
+// 64 bits with a multiply so the shard and tag bits depend on every key byte.
+static inline uint64_t key_hash(const char* key, size_t len) {
+  const uint8_t* p = (const uint8_t*)key;
+  uint32_t c = 0xFFFFFFFFu;
+  for (; len >= 8; len -= 8, p += 8) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+    c = crc32c_u64(c, w);
+  }
+  while (len--) c = crc32c_u8(c, *p++);
+  return (uint64_t)~c * 0x9E3779B97F4A7C15ULL;
+}
+
+#else  // HINOTETSU_HASH_FNV1A
+
+// FNV-1a. The last key bytes barely reach its top bits, which pick the
+// shard and the tag: fold the high half down and multiply so they depend
+// on every key byte.
+static inline uint64_t key_hash(const char* key, size_t len) {
   uint64_t h = 1469598103934665603ULL;
   for (size_t i = 0; i < len; i++) {
     h ^= (uint8_t)key[i];
     h *= 1099511628211ULL;
   }
-  return h;
+  return (h ^ (h >> 32)) * 0x9E3779B97F4A7C15ULL;
 }
 
+#endif
+
+// The shard comes from the top hash bits and the table index from the bottom
+// ones, so every slot of a shard's table can be a home slot
+#define SHARD_BITS ((uint32_t)__builtin_ctz(HINOTETSU_SHARDS))
+
 static inline uint32_t shard_id_for(uint64_t h) {
-  return (uint32_t)(h & (HINOTETSU_SHARDS - 1u));
+  return (uint32_t)((h >> 1) >> (63u - SHARD_BITS));
 }
 
 static inline uint32_t idx_for(uint64_t h, uint32_t cap) {
   return (uint32_t)(h & (uint64_t)(cap - 1u));
 }
 
-static inline void* pool_alloc(Shard* s, size_t n) {
-  n = (n + 7u) & ~7u;
-  if (s->pool_pos + n > s->pool_size) return NULL;
-  void* p = s->pool + s->pool_pos;
-  s->pool_pos += n;
-  return p;
+static inline int key_eq(const Entry* e, uint64_t h, const char* key, size_t klen) {
+  return (e && e != TOMBSTONE_PTR &&
+          e->hash == h && e->klen == klen &&
+          memcmp(e->data, key, klen) == 0);
 }
 
-static inline int key_eq(const Entry* e, const char* key, size_t klen) {
-  return (e && e != TOMBSTONE_PTR &&
-          e->klen == (uint32_t)klen &&
-          memcmp(e->key, key, klen) == 0);
+static inline const char* entry_value(const Entry* e) {
+  if (e->vclass == VALUE_INLINE) return e->data + e->klen;
+  const char* v;
+  memcpy(&v, e->data + e->klen, sizeof(v));
+  return v;
 }
 
 // --------- slab allocator ----------
-static inline void slab_push(Shard* s, uint8_t shift, void* p) {
+static inline size_t class_size(const Shard* s, uint8_t cls) {
+  return s->classes->size[cls];
+}
+
+static inline void slab_push(Shard* s, uint8_t cls, void* p) {
   SlabNode* n = (SlabNode*)p;
-  n->next = s->freelist[shift];
-  s->freelist[shift] = n;
+  n->next = s->freelist[cls];
+  s->freelist[cls] = n;
+  s->slab[cls].free++;
+}
+
+static inline uint8_t* page_base(const Shard* s, uint32_t idx) {
+  return s->arena->base + (size_t)idx * SLAB_PAGE_BYTES;
 }
 
-static void slab_refill(Shard* s, uint8_t shift) {
-  size_t bsz = class_size(shift);
-  size_t page = (size_t)HINOTETSU_SLAB_PAGE_SIZE;
-  if (page < bsz * 8) page = bsz * 8;
-  page = (page + 7u) & ~7u;
+static inline uint32_t page_index(const Shard* s, const void* p) {
+  return (uint32_t)((size_t)((const uint8_t*)p - s->arena->base) / SLAB_PAGE_BYTES);
+}
 
-  uint8_t* mem = (uint8_t*)pool_alloc(s, page);
-  if (!mem) return;
+static inline SlabPage* page_of(Shard* s, const void* p) {
+  return &s->arena->pages[page_index(s, p)];
+}
 
-  size_t blocks = page / bsz;
-  for (size_t i = 0; i < blocks; i++) {
-    slab_push(s, shift, mem + i * bsz);
+static inline ArenaChunk* chunk_of_page(const Shard* s, uint32_t idx) {
+  return &s->arena->chunks[idx / s->arena->pages_per_chunk];
+}
+
+// --------- memory mappings ----------
+// The arena and the shard tables are mapped here, zeroed and (unless the
+// caller pre-faults them itself) populated.
+// With huge pages requested a mapping first tries explicit 2MB pages
+// (MAP_HUGETLB, needs vm.nr_hugepages), then a 2MB-aligned mapping advised
+// MADV_HUGEPAGE so transparent huge pages can back it.
+#define HUGE_PAGE_BYTES (2u * 1024u * 1024u)
+
+#define MAPPING_HEAP    0u  // malloc, no mmap on this platform
+#define MAPPING_SMALL   1u  // base pages
+#define MAPPING_THP     2u  // advised for transparent huge pages
+#define MAPPING_HUGETLB 3u  // explicit huge pages
+
+// Huge page request of mapping_create
+#define HUGE_OFF 0
+#define HUGE_ANY 1          // explicit, else transparent
+#define HUGE_TRANSPARENT 2  // transparent only: explicit ones are reserved
+                            // when mapped, so they cannot back an elastic arena
+
+// Fault in [p, p + bytes) for writing without changing its contents, so
+// it can run while shards already use the memory
+static void prefault_range(uint8_t* p, size_t bytes) {
+#if USE_MMAP_ALLOC && defined(MADV_POPULATE_WRITE)
+  if (madvise(p, bytes, MADV_POPULATE_WRITE) == 0) return;
+#endif
+  for (size_t j = 0; j < bytes; j += 4096) {
+    __atomic_fetch_add(p + j, (uint8_t)0, __ATOMIC_RELAXED);
   }
 }
 
-// Pre-warm slab freelists
-static void slab_prewarm(Shard* s) {
-  for (uint8_t shift = HINOTETSU_SLAB_MIN_SHIFT; shift <= HINOTETSU_SLAB_MAX_SHIFT; shift++) {
-    // Pre-allocate 4 pages per size class
-    for (int i = 0; i < 4; i++) {
-      slab_refill(s, shift);
+#if USE_MMAP_ALLOC
+static uint8_t* map_anon(size_t bytes, int flags) {
+  void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+  return p == MAP_FAILED ? NULL : (uint8_t*)p;
+}
+
+// Over-map by a huge page and trim, so huge pages can back the mapping
+// from its first byte
+static uint8_t* map_anon_aligned(size_t bytes) {
+  size_t span = bytes + HUGE_PAGE_BYTES;
+  uint8_t* p = map_anon(span, 0);
+  if (!p) return NULL;
+  uint8_t* a = (uint8_t*)(((uintptr_t)p + HUGE_PAGE_BYTES - 1u) &
+                          ~(uintptr_t)(HUGE_PAGE_BYTES - 1u));
+  if (a > p) munmap(p, (size_t)(a - p));
+  size_t tail = (size_t)((p + span) - (a + bytes));
+  if (tail) munmap(a + bytes, tail);
+  return a;
+}
+#endif
+
+// huge is a HUGE_* request; m->kind records what was obtained. Memory from
+// the heap is always faulted in, as it has to be zeroed.
+static int mapping_create(Mapping* m, size_t bytes, int huge, int populate) {
+  memset(m, 0, sizeof(*m));
+  m->bytes = bytes;
+#if USE_MMAP_ALLOC
+  if (huge != HUGE_OFF) {
+#ifdef MAP_HUGETLB
+    size_t rounded = (bytes + HUGE_PAGE_BYTES - 1u) & ~(size_t)(HUGE_PAGE_BYTES - 1u);
+    m->base = huge == HUGE_ANY ? map_anon(rounded, MAP_HUGETLB | (populate ? MAP_POPULATE : 0)) : NULL;
+    if (m->base) {
+      m->bytes = rounded;
+      m->kind = MAPPING_HUGETLB;
+      return 1;
+    }
+#endif
+#ifdef MADV_HUGEPAGE
+    m->base = map_anon_aligned(bytes);
+    if (m->base) {
+      // Advice must precede the first touch; it fails if THP is compiled out
+      if (madvise(m->base, bytes, MADV_HUGEPAGE) == 0) m->kind = MAPPING_THP;
+      else m->kind = MAPPING_SMALL;
+      if (populate) prefault_range(m->base, bytes);
+      return 1;
     }
+#endif
   }
+  m->base = map_anon(bytes, populate ? MAP_POPULATE : 0);
+  m->kind = MAPPING_SMALL;
+#else
+  (void)huge;
+  (void)populate;
+  m->base = (uint8_t*)malloc(bytes);
+  if (m->base) memset(m->base, 0, bytes);
+  m->kind = MAPPING_HEAP;
+#endif
+  return m->base != NULL;
 }
 
-static inline void* value_alloc(Shard* s, size_t n, uint8_t* out_class) {
-  uint8_t shift = class_for_size(n);
-  *out_class = shift;
-  if (shift == VALUE_CLASS_BUMP) {
-    return pool_alloc(s, n);
+static void mapping_destroy(Mapping* m) {
+  if (!m->base) return;
+#if USE_MMAP_ALLOC
+  munmap(m->base, m->bytes);
+#else
+  free(m->base);
+#endif
+  m->base = NULL;
+}
+
+// Huge page coverage of a set of mappings. Explicit huge pages are counted
+// whole; THP coverage comes from the AnonHugePages lines of the VMAs in
+// /proc/self/smaps that overlap a THP mapping (adjacent advised mappings
+// may share a VMA, which is then counted once).
+#define HUGE_SCAN_MAX (1u + 2u * HINOTETSU_SHARDS)  // arena + two tables per shard
+
+typedef struct HugeScan {
+  size_t hugetlb_bytes;
+  uint32_t n;
+  uintptr_t lo[HUGE_SCAN_MAX];
+  uintptr_t hi[HUGE_SCAN_MAX];
+} HugeScan;
+
+static void huge_scan_add(HugeScan* hs, const Mapping* m) {
+  if (m->kind == MAPPING_HUGETLB) {
+    hs->hugetlb_bytes += m->bytes;
+  } else if (m->kind == MAPPING_THP && hs->n < HUGE_SCAN_MAX) {
+    hs->lo[hs->n] = (uintptr_t)m->base;
+    hs->hi[hs->n] = (uintptr_t)m->base + m->bytes;
+    hs->n++;
   }
-  if (s->freelist[shift] == NULL) slab_refill(s, shift);
-  SlabNode* head = s->freelist[shift];
-  if (!head) return NULL;
-  s->freelist[shift] = head->next;
-  return (void*)head;
 }
 
-static inline void value_free(Shard* s, void* p, uint8_t vclass) {
-  if (!p) return;
-  if (vclass == VALUE_CLASS_BUMP) return;
-  slab_push(s, vclass, p);
+static size_t huge_scan_finish(const HugeScan* hs) {
+  size_t total = hs->hugetlb_bytes;
+#if USE_MMAP_ALLOC
+  if (hs->n == 0) return total;
+  FILE* f = fopen("/proc/self/smaps", "r");
+  if (!f) return total;
+  char line[512];
+  int overlaps = 0;
+  while (fgets(line, sizeof(line), f)) {
+    unsigned long lo, hi, kb;
+    if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {
+      overlaps = 0;
+      for (uint32_t i = 0; i < hs->n && !overlaps; i++) {
+        overlaps = hs->lo[i] < hi && lo < hs->hi[i];
+      }
+    } else if (overlaps && sscanf(line, "AnonHugePages: %lu kB", &kb) == 1) {
+      total += (size_t)kb * 1024u;
+    }
+  }
+  fclose(f);
+#endif
+  return total;
 }
 
-// --------- entry creation ----------
-static Entry* entry_create_in_pool(Shard* s,
-                                   const char* key, size_t klen,
-                                   const char* val, size_t vlen,
-                                   uint32_t ttl) {
-  Entry* e = (Entry*)pool_alloc(s, sizeof(Entry));
-  if (!e) return NULL;
-
-  char* k = (char*)pool_alloc(s, klen);
-  if (!k) return NULL;
-  memcpy(k, key, klen);
-
-  uint8_t vclass = VALUE_CLASS_BUMP;
-  char* v = (char*)value_alloc(s, vlen, &vclass);
-  if (!v) return NULL;
-  memcpy(v, val, vlen);
-
-  e->key = k;
-  e->value = v;
-  e->klen = (uint32_t)klen;
-  e->vlen = (uint32_t)vlen;
-  e->deleted = 0;
-  e->vclass = vclass;
-  e->expire = (ttl == 0) ? 0 : (now_sec() + ttl);
-  return e;
+// --------- arena ----------
+static void chunk_list_push(Arena* a, uint32_t* head, uint32_t c) {
+  a->chunks[c].prev = ARENA_NONE;
+  a->chunks[c].next = *head;
+  if (*head != ARENA_NONE) a->chunks[*head].prev = c;
+  *head = c;
 }
 
-// --------- incremental resize ----------
+static void chunk_list_unlink(Arena* a, uint32_t* head, uint32_t c) {
+  ArenaChunk* ch = &a->chunks[c];
+  if (ch->prev != ARENA_NONE) a->chunks[ch->prev].next = ch->next;
+  else *head = ch->next;
+  if (ch->next != ARENA_NONE) a->chunks[ch->next].prev = ch->prev;
+}
+
+// Lease n contiguous chunks to a shard; ARENA_NONE if the arena is spent
+static uint32_t arena_lease(Arena* a, uint32_t* head, uint16_t owner, uint32_t n) {
+  uint32_t first = ARENA_NONE;
+  pthread_mutex_lock(&a->mu);
+  if (n == 1u) {
+    first = a->free_head;
+  } else if (n <= a->free_chunks) {
+    uint32_t run = 0;
+    for (uint32_t c = 0; c < a->chunk_count; c++) {
+      run = a->chunks[c].owner == ARENA_FREE ? run + 1u : 0u;
+      if (run == n) { first = c + 1u - n; break; }
+    }
+  }
+  if (first != ARENA_NONE) {
+    for (uint32_t c = first; c < first + n; c++) {
+      chunk_list_unlink(a, &a->free_head, c);
+      chunk_list_push(a, head, c);
+      __atomic_store_n(&a->chunks[c].owner, owner, __ATOMIC_RELEASE);
+    }
+    a->free_chunks -= n;
+  }
+  pthread_mutex_unlock(&a->mu);
+  return first;
+}
 
-// Free hash table (handles both malloc and mmap)
-static void free_table(Entry** tab, uint32_t cap) {
-  if (!tab) return;
+// Elastic arenas hand an idle chunk's memory back to the OS; it faults in
+// again, zeroed, when next used. Called by the chunk's owner.
+static void arena_discard(Arena* a, uint32_t c) {
+  if (!a->elastic) return;
 #if USE_MMAP_ALLOC
-  munmap(tab, (size_t)cap * sizeof(Entry*));
-#else
-  free(tab);
+  if (madvise(a->base + (size_t)c * HINOTETSU_ARENA_CHUNK, HINOTETSU_ARENA_CHUNK,
+              MADV_DONTNEED) == 0) {
+    __atomic_fetch_add(&a->released, (uint64_t)HINOTETSU_ARENA_CHUNK, __ATOMIC_RELAXED);
+  }
 #endif
 }
 
-// Insert entry into a table (used during migration)
-static void table_insert(Entry** tab, uint32_t cap, Entry* e, uint32_t* used) {
-  uint64_t h = fnv1a64(e->key, e->klen);
-  uint32_t idx = idx_for(h, cap);
-  while (tab[idx] != NULL && tab[idx] != TOMBSTONE_PTR) {
-    idx = (idx + 1u) & (cap - 1u);
+static void arena_release(Arena* a, uint32_t* head, uint32_t c) {
+  pthread_mutex_lock(&a->mu);
+  chunk_list_unlink(a, head, c);
+  __atomic_store_n(&a->chunks[c].owner, ARENA_FREE, __ATOMIC_RELEASE);
+  chunk_list_push(a, &a->free_head, c);
+  a->free_chunks++;
+  pthread_mutex_unlock(&a->mu);
+}
+
+static int arena_init(Arena* a, size_t bytes, int huge, int elastic) {
+  a->pages_per_chunk = (uint32_t)(HINOTETSU_ARENA_CHUNK / SLAB_PAGE_BYTES);
+  a->chunk_count = (uint32_t)((bytes + HINOTETSU_ARENA_CHUNK - 1u) / HINOTETSU_ARENA_CHUNK);
+  a->bytes = (size_t)a->chunk_count * HINOTETSU_ARENA_CHUNK;
+  a->free_head = ARENA_NONE;
+  a->elastic = elastic;
+  pthread_mutex_init(&a->mu, NULL);
+
+  // Faulted in by arena_prefault(), or on use if elastic
+  int req = !huge ? HUGE_OFF : elastic ? HUGE_TRANSPARENT : HUGE_ANY;
+  if (!mapping_create(&a->mem, a->bytes, req, 0)) return 0;
+  a->base = a->mem.base;
+  a->chunks = (ArenaChunk*)calloc(a->chunk_count, sizeof(ArenaChunk));
+  a->pages = (SlabPage*)calloc((size_t)a->chunk_count * a->pages_per_chunk, sizeof(SlabPage));
+  if (!a->chunks || !a->pages) return 0;
+
+  for (uint32_t c = a->chunk_count; c > 0; c--) {
+    a->chunks[c - 1u].owner = ARENA_FREE;
+    chunk_list_push(a, &a->free_head, c - 1u);
   }
-  if (tab[idx] == NULL) (*used)++;
-  tab[idx] = e;
+  a->free_chunks = a->chunk_count;
+  return 1;
 }
 
-// Start incremental resize
-static void shard_start_resize(Shard* s) {
-  if (s->new_tab) return;  // already resizing
+static void arena_prefault_run(Arena* a) {
+  while (!__atomic_load_n(&a->prefault_stop, __ATOMIC_RELAXED)) {
+    uint32_t c = __atomic_fetch_add(&a->prefault_next, 1u, __ATOMIC_RELAXED);
+    if (c >= a->chunk_count) return;
+    prefault_range(a->base + (size_t)c * HINOTETSU_ARENA_CHUNK, HINOTETSU_ARENA_CHUNK);
+    if (__atomic_add_fetch(&a->prefault_done, 1u, __ATOMIC_ACQ_REL) == a->chunk_count) {
+      uint64_t ns = mono_ns() - a->prefault_start_ns;
+      __atomic_store_n(&a->prefault_ns, ns ? ns : 1u, __ATOMIC_RELEASE);
+    }
+  }
+}
 
-  uint32_t new_cap = s->cap << 1u;
-  if (new_cap < HINOTETSU_INIT_CAP) new_cap = HINOTETSU_INIT_CAP;
+static void* arena_prefault_main(void* arg) {
+  arena_prefault_run((Arena*)arg);
+  return NULL;
+}
 
-  size_t bytes = (size_t)new_cap * sizeof(Entry*);
-  Entry** nt = NULL;
+static void arena_prefault_join(Arena* a) {
+  for (uint32_t i = 0; i < a->prefault_nthreads; i++) {
+    pthread_join(a->prefault_thread[i], NULL);
+  }
+  a->prefault_nthreads = 0;
+}
 
-#if USE_MMAP_ALLOC
-  // Use mmap with MAP_POPULATE to pre-fault pages
-  nt = (Entry**)mmap(NULL, bytes, PROT_READ | PROT_WRITE,
-                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
-  if (nt == MAP_FAILED) nt = NULL;
-#else
-  nt = (Entry**)malloc(bytes);
-  if (nt) memset(nt, 0, bytes);
-#endif
+// Fault in the arena with nthreads threads. Unless async, the calling
+// thread takes part and returns once every chunk is faulted in; with async
+// the threads carry on while shards serve (and fault pages themselves).
+static void arena_prefault(Arena* a, uint32_t nthreads, int async) {
+  a->prefault_start_ns = mono_ns();
+  if (a->mem.kind == MAPPING_HEAP) {
+    a->prefault_next = a->prefault_done = a->chunk_count;
+    a->prefault_ns = 1;
+    return;
+  }
+  if (nthreads > HINOTETSU_PREFAULT_MAX_THREADS) nthreads = HINOTETSU_PREFAULT_MAX_THREADS;
+  uint32_t spawn = async ? nthreads : nthreads - 1u;
+  while (a->prefault_nthreads < spawn &&
+         pthread_create(&a->prefault_thread[a->prefault_nthreads], NULL,
+                        arena_prefault_main, a) == 0) {
+    a->prefault_nthreads++;
+  }
+  if (async && a->prefault_nthreads > 0) return;
+  arena_prefault_run(a);
+  arena_prefault_join(a);
+}
 
-  if (!nt) return;
+static void arena_destroy(Arena* a) {
+  __atomic_store_n(&a->prefault_stop, 1, __ATOMIC_RELAXED);
+  arena_prefault_join(a);
+  mapping_destroy(&a->mem);
+  free(a->chunks);
+  free(a->pages);
+  pthread_mutex_destroy(&a->mu);
+}
 
-  s->new_tab = nt;
-  s->new_cap = new_cap;
-  s->new_used = 0;
-  s->migrate_pos = 0;
+// --------- pages ----------
+static void page_list_push(Shard* s, uint32_t idx) {
+  SlabPage* pg = &s->arena->pages[idx];
+  pg->kind = PAGE_FREE;
+  pg->prev = SLAB_PAGE_NONE;
+  pg->next = s->free_page;
+  if (s->free_page != SLAB_PAGE_NONE) s->arena->pages[s->free_page].prev = idx;
+  s->free_page = idx;
 }
 
-// Migrate a batch of entries from old to new table
-static void shard_migrate_batch(Shard* s) {
-  if (!s->new_tab) return;
+static void page_free_unlink(Shard* s, uint32_t idx) {
+  SlabPage* pages = s->arena->pages;
+  SlabPage* pg = &pages[idx];
+  if (pg->prev != SLAB_PAGE_NONE) pages[pg->prev].next = pg->next;
+  else s->free_page = pg->next;
+  if (pg->next != SLAB_PAGE_NONE) pages[pg->next].prev = pg->prev;
+  pg->kind = PAGE_UNUSED;
+
+  uint32_t c = idx / s->arena->pages_per_chunk;
+  s->arena->chunks[c].free_pages--;
+  if (c == s->spare_chunk) s->spare_chunk = ARENA_NONE;
+}
 
-  uint32_t now = now_sec();
-  uint32_t migrated = 0;
+// Hand a chunk whose pages are all free, already discarded, back to the arena
+static void shard_chunk_return(Shard* s, uint32_t c) {
+  uint32_t ppc = s->arena->pages_per_chunk;
+  for (uint32_t i = c * ppc; i < (c + 1u) * ppc; i++) page_free_unlink(s, i);
+  s->chunks--;
+  arena_release(s->arena, &s->chunk_head, c);
+}
 
-  while (s->migrate_pos < s->cap && migrated < HINOTETSU_MIGRATE_BATCH) {
-    Entry* e = s->tab[s->migrate_pos];
-    s->migrate_pos++;
+// Give a chunk whose pages are all free back to the arena, unless the shard
+// has no spare yet: keeping one avoids leasing it straight back
+static void shard_chunk_idle(Shard* s, uint32_t c) {
+  arena_discard(s->arena, c);
+  if (s->spare_chunk == ARENA_NONE) {
+    s->spare_chunk = c;
+    return;
+  }
+  shard_chunk_return(s, c);
+}
 
-    if (!e || e == TOMBSTONE_PTR) continue;
-    if (e->deleted || is_expired(e, now)) continue;
+// A chunk emptied under free_now may still be read lock-free, so it stays
+// with the shard until shard_grace_release()
+static void page_free_push(Shard* s, uint32_t idx) {
+  page_list_push(s, idx);
+  ArenaChunk* ch = chunk_of_page(s, idx);
+  if (++ch->free_pages == s->arena->pages_per_chunk) {
+    if (HINOTETSU_LOCKFREE_READS && s->free_now) s->chunks_held = 1;
+    else shard_chunk_idle(s, idx / s->arena->pages_per_chunk);
+  }
+}
 
-    table_insert(s->new_tab, s->new_cap, e, &s->new_used);
-    migrated++;
+// Wait out readers of what was freed under free_now, then idle the chunks
+// that emptied meanwhile and were not reused since
+static void shard_grace_release(Shard* s) {
+  shard_grace(s);
+  if (!s->chunks_held) return;
+  s->chunks_held = 0;
+  Arena* a = s->arena;
+  uint32_t c = s->chunk_head;
+  while (c != ARENA_NONE) {
+    uint32_t next = a->chunks[c].next;
+    if (c != s->spare_chunk && a->chunks[c].free_pages == a->pages_per_chunk) {
+      shard_chunk_idle(s, c);
+    }
+    c = next;
   }
+}
 
-  // Check if migration complete
-  if (s->migrate_pos >= s->cap) {
-    uint32_t old_cap = s->cap;
-    free_table(s->tab, old_cap);
-    s->tab = s->new_tab;
-    s->cap = s->new_cap;
-    s->used = s->new_used;
-    s->new_tab = NULL;
-    s->new_cap = 0;
-    s->new_used = 0;
-    s->migrate_pos = 0;
+// Shards sit in one array, indexed by id
+static inline Shard* shard_peer(Shard* s, uint32_t id) {
+  return s - s->id + id;
+}
 
-    // Recount live entries
-    uint32_t live = 0;
-    for (uint32_t i = 0; i < s->cap; i++) {
-      Entry* e = s->tab[i];
-      if (e && e != TOMBSTONE_PTR && !e->deleted) live++;
+// Collect the spare chunks of the other shards once the arena is spent.
+// The caller holds its own shard's lock, so peers busy with a write of
+// their own are skipped rather than waited for. Returns 1 if any came back.
+static int shard_spares_collect(Shard* s) {
+  int got = 0;
+  for (uint32_t i = 1; i < HINOTETSU_SHARDS; i++) {
+    Shard* v = shard_peer(s, (s->id + i) % HINOTETSU_SHARDS);
+    if (!shard_write_trylock(v)) continue;
+    if (v->spare_chunk != ARENA_NONE) {
+      shard_chunk_return(v, v->spare_chunk);
+      got = 1;
     }
-    s->count = live;
+    shard_write_unlock(v);
   }
+  return got;
 }
 
-// Check if resize needed and handle migration
-static inline void shard_maybe_grow(Shard* s) {
-  // Always do a migration batch if in progress
-  if (s->new_tab) {
-    shard_migrate_batch(s);
-    return;
+static int shard_chunk_lease(Shard* s, uint32_t n) {
+  Arena* a = s->arena;
+  uint32_t first = arena_lease(a, &s->chunk_head, s->id, n);
+  if (first == ARENA_NONE && shard_spares_collect(s)) {
+    first = arena_lease(a, &s->chunk_head, s->id, n);
+  }
+  if (first == ARENA_NONE) return 0;
+  uint32_t ppc = a->pages_per_chunk;
+  for (uint32_t c = first; c < first + n; c++) {
+    memset(&a->pages[c * ppc], 0, (size_t)ppc * sizeof(SlabPage));
+    for (uint32_t i = (c + 1u) * ppc; i > c * ppc; i--) page_list_push(s, i - 1u);
+    a->chunks[c].free_pages = (uint16_t)ppc;
   }
+  s->chunks += n;
+  return 1;
+}
 
-  // Check if we need to start resize
-  if (s->used + 1u > (uint32_t)((uint64_t)s->cap * LOAD_FACTOR_NUM / LOAD_FACTOR_DEN)) {
-    shard_start_resize(s);
-    if (s->new_tab) {
-      shard_migrate_batch(s);
+// First of n contiguous free pages held by the shard, SLAB_PAGE_NONE if none
+static uint32_t page_run_find(Shard* s, uint32_t n) {
+  if (n == 1u) return s->free_page;
+  const Arena* a = s->arena;
+  uint32_t page_count = a->chunk_count * a->pages_per_chunk;
+  for (uint32_t idx = s->free_page; idx != SLAB_PAGE_NONE; idx = a->pages[idx].next) {
+    if (idx + n > page_count) continue;
+    uint32_t i = idx;
+    // Pages of other shards' chunks change under their locks: check the
+    // owner before looking at the page
+    while (i < idx + n &&
+           __atomic_load_n(&chunk_of_page(s, i)->owner, __ATOMIC_ACQUIRE) == s->id &&
+           a->pages[i].kind == PAGE_FREE) {
+      i++;
     }
+    if (i == idx + n) return idx;
   }
+  return SLAB_PAGE_NONE;
 }
 
-// Find slot - searches both old and new tables during resize
-static uint32_t shard_find_slot(Shard* s, const char* key, size_t klen, uint64_t h,
-                                int* found, Entry*** out_tab, uint32_t* out_cap) {
-  // First check new table if resizing
-  if (s->new_tab) {
-    uint32_t cap = s->new_cap;
-    uint32_t idx = idx_for(h, cap);
-    uint32_t first_tomb = UINT32_MAX;
-
-    for (uint32_t i = 0; i < cap; i++) {
-      Entry* cur = s->new_tab[idx];
-      if (cur == NULL) {
-        // Not in new table, check old table
-        break;
-      }
-      if (cur == TOMBSTONE_PTR) {
-        if (first_tomb == UINT32_MAX) first_tomb = idx;
-      } else if (key_eq(cur, key, klen)) {
-        *found = 1;
-        *out_tab = &s->new_tab;
-        *out_cap = s->new_cap;
-        return idx;
+static void shard_reclaim(Shard* s, int wait);
+
+// Take n contiguous pages, leasing chunks when the shard has no such run.
+// Entries waiting in limbo are freed before the shard grows: overwrites
+// would otherwise keep leasing while the old values wait out the readers.
+// Returns the first page, SLAB_PAGE_NONE if there is no room.
+static uint32_t slab_pages_take(Shard* s, uint32_t n) {
+  uint32_t idx = page_run_find(s, n);
+  if (idx == SLAB_PAGE_NONE && s->limbo_count && !s->free_now) {
+    shard_reclaim(s, 1);
+    idx = page_run_find(s, n);
+  }
+  if (idx == SLAB_PAGE_NONE) {
+    uint32_t ppc = s->arena->pages_per_chunk;
+    if (!shard_chunk_lease(s, (n + ppc - 1u) / ppc)) return SLAB_PAGE_NONE;
+    idx = page_run_find(s, n);
+    if (idx == SLAB_PAGE_NONE) return SLAB_PAGE_NONE;
+  }
+  for (uint32_t i = idx; i < idx + n; i++) page_free_unlink(s, i);
+  return idx;
+}
+
+// Return every chunk to the arena
+static void shard_chunks_release(Shard* s) {
+  while (s->chunk_head != ARENA_NONE) {
+    uint32_t c = s->chunk_head;
+    if (c != s->spare_chunk) arena_discard(s->arena, c);  // the spare already was
+    arena_release(s->arena, &s->chunk_head, c);
+  }
+  s->chunks = 0;
+  s->spare_chunk = ARENA_NONE;
+  s->free_page = SLAB_PAGE_NONE;
+}
+
+static void slab_refill(Shard* s, uint8_t cls) {
+  uint32_t idx = slab_pages_take(s, 1u);
+  if (idx == SLAB_PAGE_NONE) return;
+
+  SlabPage* pg = &s->arena->pages[idx];
+  pg->kind = PAGE_CLASS;
+  pg->cls = cls;
+  pg->used = 0;
+  pg->values = 0;
+
+  uint8_t* mem = page_base(s, idx);
+  size_t bsz = class_size(s, cls);
+  size_t blocks = SLAB_PAGE_BYTES / bsz;
+  for (size_t i = 0; i < blocks; i++) {
+    slab_push(s, cls, mem + i * bsz);
+  }
+  s->slab[cls].pages++;
+  s->slab[cls].chunks += (uint32_t)blocks;
+}
+
+// Pre-warm slab freelists: a page per class from one leased chunk, as long
+// as that leaves at least three quarters of the arena unleased. Elastic
+// arenas lease nothing until it is used.
+static void slab_prewarm(Shard* s) {
+  if (s->arena->elastic || s->arena->chunk_count < 4u * HINOTETSU_SHARDS) return;
+  for (uint8_t cls = 0; cls < s->classes->count; cls++) {
+    if (s->chunks && s->free_page == SLAB_PAGE_NONE) break;
+    slab_refill(s, cls);
+  }
+}
+
+static void slab_reset(Shard* s) {
+  memset(s->freelist, 0, sizeof(s->freelist));
+  memset(s->slab, 0, sizeof(s->slab));
+  shard_chunks_release(s);
+  memset(s->large_bin, 0, sizeof(s->large_bin));
+  memset(&s->large_queue, 0, sizeof(s->large_queue));
+  s->large_pages = 0;
+  s->large_starved = 0;
+  s->large_items = 0;
+  s->large_bytes = 0;
+  s->large_requested = 0;
+  slab_prewarm(s);
+}
+
+// --------- large-object allocator ----------
+static inline uint32_t large_bin_for(size_t size) {
+  uint32_t b = 63u - (uint32_t)__builtin_clzll((unsigned long long)size);
+  b = b > LARGE_BIN_SHIFT ? b - LARGE_BIN_SHIFT : 0u;
+  return b < LARGE_BINS ? b : LARGE_BINS - 1u;
+}
+
+static inline size_t* large_footer(uint8_t* x, size_t size) {
+  return (size_t*)(x + size) - 1;
+}
+
+static inline void large_set_tags(uint8_t* x, size_t size, size_t used) {
+  *(size_t*)x = size | used;
+  *large_footer(x, size) = size | used;
+}
+
+static void large_bin_push(Shard* s, LargeFree* f, size_t size) {
+  large_set_tags((uint8_t*)f, size, 0);
+  LargeFree** bin = &s->large_bin[large_bin_for(size)];
+  f->prev = NULL;
+  f->next = *bin;
+  if (*bin) (*bin)->prev = f;
+  *bin = f;
+}
+
+static void large_bin_unlink(Shard* s, LargeFree* f) {
+  if (f->prev) f->prev->next = f->next;
+  else s->large_bin[large_bin_for(f->tag)] = f->next;
+  if (f->next) f->next->prev = f->prev;
+}
+
+// Carve a span of whole pages holding at least need bytes of extent
+static int large_span_add(Shard* s, size_t need) {
+  size_t bytes = need + 2u * LARGE_TAG;
+  uint32_t n = (uint32_t)((bytes + SLAB_PAGE_BYTES - 1u) / SLAB_PAGE_BYTES);
+  uint32_t first = slab_pages_take(s, n);
+  if (first == SLAB_PAGE_NONE) return 0;
+  for (uint32_t i = first; i < first + n; i++) {
+    memset(&s->arena->pages[i], 0, sizeof(SlabPage));
+    s->arena->pages[i].kind = PAGE_LARGE;
+  }
+  s->large_pages += n;
+
+  uint8_t* base = page_base(s, first);
+  size_t span = (size_t)n * SLAB_PAGE_BYTES;
+  *(size_t*)base = LARGE_USED;
+  *(size_t*)(base + span - LARGE_TAG) = LARGE_USED;
+  large_bin_push(s, (LargeFree*)(base + LARGE_TAG), span - 2u * LARGE_TAG);
+  return 1;
+}
+
+static LargeFree* large_find(Shard* s, size_t need) {
+  uint32_t b = large_bin_for(need);
+  // Extents in the first bin may be too small; any in a higher bin fit
+  for (LargeFree* f = s->large_bin[b]; f; f = f->next) {
+    if (f->tag >= need) return f;
+  }
+  for (b++; b < LARGE_BINS; b++) {
+    if (s->large_bin[b]) return s->large_bin[b];
+  }
+  return NULL;
+}
+
+static void* large_alloc(Shard* s, size_t n) {
+  size_t need = ((n + 7u) & ~(size_t)7u) + LARGE_OVERHEAD;
+  LargeFree* f = large_find(s, need);
+  if (!f) {
+    if (!large_span_add(s, need)) return NULL;
+    f = large_find(s, need);
+  }
+  large_bin_unlink(s, f);
+
+  size_t size = f->tag;
+  if (size - need >= LARGE_MIN_EXTENT) {
+    large_bin_push(s, (LargeFree*)((uint8_t*)f + need), size - need);
+    size = need;
+  }
+  large_set_tags((uint8_t*)f, size, LARGE_USED);
+  s->large_items++;
+  s->large_bytes += size;
+  s->large_requested += n;
+  return (uint8_t*)f + LARGE_TAG;
+}
+
+static inline size_t large_extent_size(const void* p) {
+  return *(const size_t*)((const uint8_t*)p - LARGE_TAG) & ~LARGE_USED;
+}
+
+static void large_free(Shard* s, void* p, size_t n) {
+  uint8_t* x = (uint8_t*)p - LARGE_TAG;
+  size_t size = large_extent_size(p);
+  s->large_items--;
+  s->large_bytes -= size;
+  s->large_requested -= n;
+
+  size_t prev = *(size_t*)(x - LARGE_TAG);
+  if (!(prev & LARGE_USED)) {
+    x -= prev;
+    large_bin_unlink(s, (LargeFree*)x);
+    size += prev;
+  }
+  size_t next = *(size_t*)(x + size);
+  if (!(next & LARGE_USED)) {
+    large_bin_unlink(s, (LargeFree*)(x + size));
+    size += next;
+  }
+
+  // The span edge tags are zero-sized: if both neighbours are edges, the
+  // whole span is free and its pages can serve slab classes again
+  if (*(size_t*)(x - LARGE_TAG) == LARGE_USED && *(size_t*)(x + size) == LARGE_USED) {
+    uint8_t* base = x - LARGE_TAG;
+    uint32_t first = page_index(s, base);
+    uint32_t pages = (uint32_t)((size + 2u * LARGE_TAG) / SLAB_PAGE_BYTES);
+    for (uint32_t i = first + pages; i > first; i--) page_free_push(s, i - 1u);
+    s->large_pages -= pages;
+    return;
+  }
+  large_bin_push(s, (LargeFree*)x, size);
+}
+
+static inline void* value_alloc(Shard* s, size_t n, uint8_t* out_class) {
+  uint8_t cls = class_for_size(s->classes, n);
+  *out_class = cls;
+  if (cls == VALUE_CLASS_LARGE) {
+    return large_alloc(s, n);
+  }
+  if (s->freelist[cls] == NULL) slab_refill(s, cls);
+  SlabNode* head = s->freelist[cls];
+  if (!head) return NULL;
+  s->freelist[cls] = head->next;
+  s->slab[cls].free--;
+  s->slab[cls].requested += n;
+  page_of(s, head)->used++;
+  return (void*)head;
+}
+
+// n is the size originally requested from value_alloc
+static inline void value_free(Shard* s, void* p, uint8_t vclass, size_t n) {
+  if (!p) return;
+  if (vclass == VALUE_CLASS_LARGE) {
+    large_free(s, p, n);
+    return;
+  }
+  s->slab[vclass].requested -= n;
+  page_of(s, p)->used--;
+  slab_push(s, vclass, p);
+}
+
+// --------- entry creation ----------
+// Chunk size of an entry: inline when header + key + value fit the slab
+// classes, otherwise header + key + pointer to the value.
+static inline size_t entry_size(size_t klen, size_t vlen, int* is_inline) {
+  size_t inline_size = sizeof(Entry) + klen + vlen;
+  *is_inline = inline_size <= SLAB_MAX_CHUNK;
+  return *is_inline ? inline_size : sizeof(Entry) + klen + sizeof(char*);
+}
+
+// Size requested for an existing entry's chunk
+static inline size_t entry_chunk_request(const Entry* e) {
+  return sizeof(Entry) + e->klen + (e->vclass == VALUE_INLINE ? e->vlen : sizeof(char*));
+}
+
+// Memory held by an entry: its chunk plus any out-of-line value
+static inline size_t entry_bytes(const Shard* s, const Entry* e) {
+  size_t n = class_size(s, e->eclass);
+  if (e->vclass == VALUE_CLASS_LARGE) n += large_extent_size(entry_value(e));
+  else if (e->vclass != VALUE_INLINE) n += class_size(s, e->vclass);
+  return n;
+}
+
+// Lay out the entry in one chunk when it fits the slab classes, so a lookup
+// touches the table slot and this chunk only. On failure nothing is leaked
+// and *failed_class tells the caller which size class ran dry.
+static Entry* entry_create_in_pool(Shard* s,
+                                   const char* key, size_t klen,
+                                   const char* val, size_t vlen,
+                                   uint64_t ttl_ms, uint8_t* failed_class) {
+  int is_inline = 0;
+  size_t esize = entry_size(klen, vlen, &is_inline);
+  // Entry headers always take a slab chunk
+  if (klen > UINT16_MAX || esize > SLAB_MAX_CHUNK ||
+      (!is_inline && vlen + LARGE_OVERHEAD + 2u * LARGE_TAG > s->arena->bytes)) {
+    *failed_class = VALUE_CLASS_NONE;
+    return NULL;
+  }
+
+  uint8_t eclass = VALUE_CLASS_NONE;
+  Entry* e = (Entry*)value_alloc(s, esize, &eclass);
+  if (!e) { *failed_class = eclass; return NULL; }
+
+  uint8_t vclass = VALUE_INLINE;
+  if (is_inline) {
+    memcpy(e->data + klen, val, vlen);
+  } else {
+    char* v = (char*)value_alloc(s, vlen, &vclass);
+    if (!v) {
+      *failed_class = vclass;
+      value_free(s, e, eclass, esize);
+      return NULL;
+    }
+    memcpy(v, val, vlen);
+    memcpy(e->data + klen, &v, sizeof(v));
+    if (vclass != VALUE_CLASS_LARGE) page_of(s, v)->values++;
+  }
+  memcpy(e->data, key, klen);
+
+  e->prev = NULL;
+  e->next = NULL;
+  e->klen = (uint16_t)klen;
+  e->vlen = (uint32_t)vlen;
+  e->eclass = eclass;
+  e->vclass = vclass;
+  e->visited = 0;
+  e->refs = 0;
+  e->wnext = NULL;
+  e->wpprev = NULL;
+  if (ttl_ms == 0) {
+    e->expire = 0;
+    e->expire_ms = 0;
+  } else {
+    uint64_t deadline = shard_now(s) + ttl_ms;
+    e->expire = (uint32_t)(deadline / 1000u);
+    e->expire_ms = (uint16_t)(deadline % 1000u);
+  }
+  s->item_bytes += entry_bytes(s, e);
+  return e;
+}
+
+static inline void entry_free_now(Shard* s, Entry* e) {
+  s->item_bytes -= entry_bytes(s, e);
+  if (e->vclass != VALUE_INLINE && e->vclass != VALUE_CLASS_LARGE) page_of(s, entry_value(e))->values--;
+  if (e->vclass != VALUE_INLINE) value_free(s, (void*)entry_value(e), e->vclass, e->vlen);
+  value_free(s, e, e->eclass, entry_chunk_request(e));
+}
+
+// --------- limbo ----------
+// With HINOTETSU_LOCKFREE_READS an unlinked entry may still be read, so its
+// memory goes back to the allocator only once the epoch has moved two past
+// the one it was freed in. Entries are kept by epoch modulo 3, linked
+// through next (they are off the eviction queue by now). Writes try to
+// move the epoch on once LIMBO_BATCH entries wait.
+#define LIMBO_BATCH 64u
+
+static void limbo_free(Shard* s, uint32_t i) {
+  Entry* e = s->limbo[i];
+  while (e) {
+    Entry* next = e->next;
+    entry_free_now(s, e);
+    s->limbo_count--;
+    e = next;
+  }
+  s->limbo[i] = NULL;
+}
+
+static void limbo_push(Shard* s, Entry* e) {
+  uint64_t now = __atomic_load_n(&s->readers->epoch, __ATOMIC_SEQ_CST);
+  uint32_t i = (uint32_t)(now % 3u);
+  if (s->limbo_epoch[i] != now) {
+    limbo_free(s, i);  // from epoch now - 3 or earlier
+    s->limbo_epoch[i] = now;
+  }
+  e->next = s->limbo[i];
+  s->limbo[i] = e;
+  s->limbo_count++;
+}
+
+// Free what no reader can see any more. With wait, wait for the readers
+// first so that the limbo empties.
+static void shard_reclaim(Shard* s, int wait) {
+  if (s->limbo_count == 0) return;
+  Readers* r = s->readers;
+  if (wait) {
+    uint64_t target = 0;
+    for (uint32_t i = 0; i < 3u; i++) {
+      if (s->limbo[i] && s->limbo_epoch[i] + 2u > target) target = s->limbo_epoch[i] + 2u;
+    }
+    ebr_wait(r, target);
+  } else {
+    ebr_try_advance(r);
+  }
+  uint64_t now = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+  for (uint32_t i = 0; i < 3u; i++) {
+    if (s->limbo[i] && s->limbo_epoch[i] + 2u <= now) limbo_free(s, i);
+  }
+}
+
+static inline void entry_free(Shard* s, Entry* e) {
+  if (HINOTETSU_LOCKFREE_READS && !s->free_now) {
+    limbo_push(s, e);
+    return;
+  }
+  entry_free_now(s, e);
+}
+
+// --------- timing wheel ----------
+// Entries with a TTL hang off a per-shard hierarchical timing wheel keyed by
+// their expire second. Level l slots span 64^l seconds; an entry sits in the
+// lowest level whose range covers its remaining time and cascades down as
+// the wheel turns, so each step only touches entries that are due.
+static inline void wheel_link(Entry** head, Entry* e) {
+  e->wnext = *head;
+  e->wpprev = head;
+  if (*head) (*head)->wpprev = &e->wnext;
+  *head = e;
+}
+
+static void wheel_insert(TimerWheel* w, Entry* e) {
+  uint32_t tick = entry_expire_tick(e);
+  uint32_t delta = tick > w->now ? tick - w->now : 0u;
+  if (delta < WHEEL_SLOTS) {
+    uint32_t t = tick > w->now ? tick : w->now;
+    wheel_link(&w->slot[0][t & (WHEEL_SLOTS - 1u)], e);
+    return;
+  }
+  for (uint32_t l = 1; l < WHEEL_LEVELS; l++) {
+    if ((uint64_t)delta < (1ULL << (WHEEL_BITS * (l + 1u)))) {
+      wheel_link(&w->slot[l][(tick >> (WHEEL_BITS * l)) & (WHEEL_SLOTS - 1u)], e);
+      return;
+    }
+  }
+  wheel_link(&w->overflow, e);
+}
+
+static inline void wheel_add(TimerWheel* w, Entry* e) {
+  wheel_insert(w, e);
+  w->items++;
+}
+
+static inline void wheel_unlink(TimerWheel* w, Entry* e) {
+  if (!e->wpprev) return;
+  *e->wpprev = e->wnext;
+  if (e->wnext) e->wnext->wpprev = e->wpprev;
+  e->wnext = NULL;
+  e->wpprev = NULL;
+  w->items--;
+}
+
+// Re-file every entry of a list against the current wheel position
+static void wheel_cascade(TimerWheel* w, Entry** head) {
+  Entry* e = *head;
+  *head = NULL;
+  while (e) {
+    Entry* next = e->wnext;
+    wheel_insert(w, e);
+    e = next;
+  }
+}
+
+static void wheel_reset(TimerWheel* w, uint32_t now) {
+  memset(w, 0, sizeof(*w));
+  w->now = now;
+}
+
+// --------- eviction queue ----------
+// Entries with a large value are queued apart: evicting them is what frees
+// extents, while the others free slab chunks of their class
+static inline EntryQueue* entry_queue(Shard* s, const Entry* e) {
+  return e->vclass == VALUE_CLASS_LARGE ? &s->large_queue : &s->queue[e->eclass];
+}
+
+static inline void queue_push_head(Shard* s, Entry* e) {
+  EntryQueue* q = entry_queue(s, e);
+  e->prev = NULL;
+  e->next = q->head;
+  if (q->head) q->head->prev = e;
+  else q->tail = e;
+  q->head = e;
+}
+
+static inline void queue_unlink(Shard* s, Entry* e) {
+  EntryQueue* q = entry_queue(s, e);
+  if (q->hand == e) q->hand = e->prev;
+  if (e->prev) e->prev->next = e->next;
+  else q->head = e->next;
+  if (e->next) e->next->prev = e->prev;
+  else q->tail = e->prev;
+  e->prev = NULL;
+  e->next = NULL;
+}
+
+// Record a hit
+static inline void entry_touch(Shard* s, Entry* e) {
+#if HINOTETSU_EVICTION == HINOTETSU_EVICT_LRU
+  if (entry_queue(s, e)->head != e) {
+    queue_unlink(s, e);
+    queue_push_head(s, e);
+  }
+#else
+  // Readers share the lock; the bit is only cleared under the write lock
+  (void)s;
+  if (!__atomic_load_n(&e->visited, __ATOMIC_RELAXED)) {
+    __atomic_store_n(&e->visited, 1u, __ATOMIC_RELAXED);
+  }
+#endif
+}
+
+// Choose the next entry of a queue to evict. Expired entries are taken
+// regardless of their reference bit.
+static Entry* queue_pick_victim(Shard* s, EntryQueue* q, uint64_t now) {
+#if HINOTETSU_EVICTION == HINOTETSU_EVICT_SIEVE
+  (void)s;
+  Entry* e = q->hand ? q->hand : q->tail;
+  while (e) {
+    if (!e->visited || is_expired(e, now)) {
+      q->hand = e->prev;
+      return e;
+    }
+    e->visited = 0;
+    e = e->prev ? e->prev : q->tail;
+  }
+  return NULL;
+#elif HINOTETSU_EVICTION == HINOTETSU_EVICT_CLOCK
+  for (;;) {
+    Entry* e = q->tail;
+    if (!e) return NULL;
+    if (!e->visited || is_expired(e, now)) return e;
+    // Second chance: clear the bit and rotate to the head
+    e->visited = 0;
+    queue_unlink(s, e);
+    queue_push_head(s, e);
+  }
+#else
+  (void)s;
+  (void)now;
+  return q->tail;
+#endif
+}
+
+// -------------------- hash tables --------------------
+// HINOTETSU_TABLE_LINEAR: Entry* slots with linear probing and tombstones.
+// HINOTETSU_TABLE_SWISS: a control byte per slot (7-bit hash tag, EMPTY or
+// DELETED) scanned a group at a time with SIMD; only tag matches touch the
+// Entry, which allows a higher load factor.
+// HINOTETSU_TABLE_ROBINHOOD: Entry* slots with Robin Hood insertion and
+// backward-shift delete, so deletes never leave tombstones and probe lengths
+// depend only on the live count.
+// HINOTETSU_TABLE_CUCKOO: buckets of four slots with an 8-bit tag each; a
+// key lives in one of two buckets, and inserts move entries along a cuckoo
+// path to make room, which allows the highest load factor. Entries no path
+// can place go to a small stash after the buckets.
+//
+// A table is one mapping: header, control bytes (SWISS, CUCKOO), then the
+// slots. table_insert() returns 0 if there is no room, which only a CUCKOO
+// table can run into.
+#if HINOTETSU_TABLE == HINOTETSU_TABLE_CUCKOO
+#define TABLE_STASH 32u  // slots past cap, scanned only while any is in use
+#else
+#define TABLE_STASH 0u
+#endif
+
+typedef struct Table {
+  uint32_t cap;
+  uint32_t used;    // slots that do not end a probe: live + tombstones (if any)
+  uint32_t stashed; // CUCKOO: entries in the stash
+  Mapping map;      // holds this header
+  uint8_t* ctrl;    // NULL for LINEAR
+  Entry** slots;
+} Table;
+
+#define TABLE_HDR_SIZE 64u
+
+static inline uint32_t table_span(const Table* t) {
+  return t->cap + TABLE_STASH;
+}
+
+// Empty every slot; lock-free readers may be probing them meanwhile
+static void table_clear_slots(Table* t) {
+#if HINOTETSU_LOCKFREE_READS
+  for (uint32_t i = 0; i < table_span(t); i++) SHARED_STORE(t->slots[i], (Entry*)NULL);
+#else
+  memset(t->slots, 0, (size_t)table_span(t) * sizeof(Entry*));
+#endif
+  t->used = 0;
+}
+
+#if HINOTETSU_TABLE == HINOTETSU_TABLE_SWISS
+
+#define LOAD_FACTOR_NUM 7u
+#define LOAD_FACTOR_DEN 8u
+#define TABLE_CTRL_BYTES(cap) ((size_t)(cap))
+
+#define CTRL_EMPTY   ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xFE)
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GROUP_WIDTH 32u
+typedef uint32_t GroupMask;
+
+static inline GroupMask group_match(const uint8_t* ctrl, uint8_t tag) {
+  __m256i g = _mm256_loadu_si256((const __m256i*)ctrl);
+  return (GroupMask)_mm256_movemask_epi8(_mm256_cmpeq_epi8(g, _mm256_set1_epi8((char)tag)));
+}
+
+// EMPTY and DELETED both have the high bit set
+static inline GroupMask group_match_free(const uint8_t* ctrl) {
+  return (GroupMask)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)ctrl));
+}
+
+static inline uint32_t mask_first(GroupMask m) {
+  return (uint32_t)__builtin_ctz(m);
+}
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define GROUP_WIDTH 16u
+typedef uint32_t GroupMask;
+
+static inline GroupMask group_match(const uint8_t* ctrl, uint8_t tag) {
+  __m128i g = _mm_loadu_si128((const __m128i*)ctrl);
+  return (GroupMask)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)tag)));
+}
+
+// EMPTY and DELETED both have the high bit set
+static inline GroupMask group_match_free(const uint8_t* ctrl) {
+  return (GroupMask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+}
+
+static inline uint32_t mask_first(GroupMask m) {
+  return (uint32_t)__builtin_ctz(m);
+}
+#else
+// Portable fallback: 8 control bytes per 64-bit word. Tag matches may
+// report a false positive next to a true one; callers compare keys anyway.
+#define GROUP_WIDTH 8u
+typedef uint64_t GroupMask;
+
+#define CTRL_LSBS 0x0101010101010101ULL
+#define CTRL_MSBS 0x8080808080808080ULL
+
+static inline uint64_t group_load(const uint8_t* ctrl) {
+  uint64_t w;
+  memcpy(&w, ctrl, sizeof(w));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  w = __builtin_bswap64(w);
+#endif
+  return w;
+}
+
+static inline GroupMask group_match(const uint8_t* ctrl, uint8_t tag) {
+  uint64_t x = group_load(ctrl) ^ (CTRL_LSBS * tag);
+  return (x - CTRL_LSBS) & ~x & CTRL_MSBS;
+}
+
+static inline GroupMask group_match_free(const uint8_t* ctrl) {
+  return group_load(ctrl) & CTRL_MSBS;
+}
+
+static inline uint32_t mask_first(GroupMask m) {
+  return (uint32_t)__builtin_ctzll(m) >> 3;
+}
+#endif
+
+// EMPTY is the only control byte with bit 7 set and bit 1 clear
+static inline GroupMask group_match_empty(const uint8_t* ctrl) {
+#if GROUP_WIDTH == 8u
+  uint64_t w = group_load(ctrl);
+  return w & ~(w << 6) & CTRL_MSBS;
+#else
+  return group_match(ctrl, CTRL_EMPTY);
+#endif
+}
+
+// 7 bits just below the shard bits, clear of the index bits
+static inline uint8_t tag_for(uint64_t h) {
+  return (uint8_t)((h >> (57u - SHARD_BITS)) & 0x7Fu);
+}
+
+static inline Entry* table_at(const Table* t, uint32_t idx) {
+  return (SHARED_LOAD(t->ctrl[idx]) & 0x80u) ? NULL : SHARED_LOAD(t->slots[idx]);
+}
+
+// A slot is filled before its tag and cleared after it, but a lock-free
+// reader may still read a tag match whose slot was just emptied
+static Entry* table_find(const Table* t, const char* key, size_t klen, uint64_t h,
+                         uint32_t* out_idx) {
+  uint32_t gmask = t->cap / GROUP_WIDTH - 1u;
+  uint32_t g = idx_for(h, gmask + 1u);
+  uint8_t tag = tag_for(h);
+  for (uint32_t probe = 0; probe <= gmask; probe++) {
+    const uint8_t* ctrl = t->ctrl + (size_t)g * GROUP_WIDTH;
+    for (GroupMask m = group_match(ctrl, tag); m; m &= m - 1u) {
+      uint32_t idx = g * GROUP_WIDTH + mask_first(m);
+      Entry* e = SHARED_LOAD(t->slots[idx]);
+      if (key_eq(e, h, key, klen)) {
+        *out_idx = idx;
+        return e;
+      }
+    }
+    if (group_match_empty(ctrl)) return NULL;
+    g = (g + probe + 1u) & gmask;  // triangular probing visits every group
+  }
+  return NULL;
+}
+
+static int table_find_ptr(const Table* t, uint64_t h, const Entry* e, uint32_t* out_idx) {
+  uint32_t gmask = t->cap / GROUP_WIDTH - 1u;
+  uint32_t g = idx_for(h, gmask + 1u);
+  uint8_t tag = tag_for(h);
+  for (uint32_t probe = 0; probe <= gmask; probe++) {
+    const uint8_t* ctrl = t->ctrl + (size_t)g * GROUP_WIDTH;
+    for (GroupMask m = group_match(ctrl, tag); m; m &= m - 1u) {
+      uint32_t idx = g * GROUP_WIDTH + mask_first(m);
+      if (t->slots[idx] == e) {
+        *out_idx = idx;
+        return 1;
+      }
+    }
+    if (group_match_empty(ctrl)) return 0;
+    g = (g + probe + 1u) & gmask;
+  }
+  return 0;
+}
+
+// Insert an entry whose key is known to be absent
+static int table_insert(Table* t, uint64_t h, Entry* e) {
+  uint32_t gmask = t->cap / GROUP_WIDTH - 1u;
+  uint32_t g = idx_for(h, gmask + 1u);
+  for (uint32_t probe = 0; probe <= gmask; probe++) {
+    GroupMask m = group_match_free(t->ctrl + (size_t)g * GROUP_WIDTH);
+    if (m) {
+      uint32_t idx = g * GROUP_WIDTH + mask_first(m);
+      if (t->ctrl[idx] == CTRL_EMPTY) t->used++;
+      SHARED_STORE(t->slots[idx], e);
+      SHARED_STORE(t->ctrl[idx], tag_for(h));
+      return 1;
+    }
+    g = (g + probe + 1u) & gmask;
+  }
+  return 0;
+}
+
+static inline void table_erase(Table* t, uint32_t idx) {
+  // A group that still has an EMPTY slot ends every probe that reaches it,
+  // so no chain can run through this slot and it may become EMPTY again
+  if (group_match_empty(t->ctrl + (idx & ~(GROUP_WIDTH - 1u)))) {
+    SHARED_STORE(t->ctrl[idx], CTRL_EMPTY);
+    t->used--;
+  } else {
+    SHARED_STORE(t->ctrl[idx], CTRL_DELETED);
+  }
+  SHARED_STORE(t->slots[idx], (Entry*)NULL);
+}
+
+static void table_clear(Table* t) {
+#if HINOTETSU_LOCKFREE_READS
+  for (uint32_t i = 0; i < t->cap; i++) SHARED_STORE(t->ctrl[i], CTRL_EMPTY);
+#else
+  memset(t->ctrl, CTRL_EMPTY, TABLE_CTRL_BYTES(t->cap));
+#endif
+  table_clear_slots(t);
+}
+
+static inline int table_is_tombstone(const Table* t, uint32_t idx) {
+  return t->ctrl[idx] == CTRL_DELETED;
+}
+
+// Probe steps (groups) from the home group to the group holding idx
+static uint32_t table_displacement(const Table* t, uint32_t home, uint32_t idx) {
+  uint32_t gmask = t->cap / GROUP_WIDTH - 1u;
+  uint32_t target = idx / GROUP_WIDTH;
+  uint32_t g = home;
+  uint32_t probe = 0;
+  while (g != target && probe <= gmask) {
+    g = (g + probe + 1u) & gmask;
+    probe++;
+  }
+  return probe;
+}
+
+#elif HINOTETSU_TABLE == HINOTETSU_TABLE_ROBINHOOD
+
+#define LOAD_FACTOR_NUM 9u
+#define LOAD_FACTOR_DEN 10u
+#define TABLE_CTRL_BYTES(cap) ((size_t)0)
+#define GROUP_WIDTH 1u
+
+// Distance of the entry in slot idx from its home slot
+static inline uint32_t rh_dist(const Table* t, const Entry* e, uint32_t idx) {
+  return (idx - idx_for(e->hash, t->cap)) & (t->cap - 1u);
+}
+
+static inline Entry* table_at(const Table* t, uint32_t idx) {
+  return SHARED_LOAD(t->slots[idx]);
+}
+
+// A probe ends at an empty slot or at an entry closer to its home than we
+// are to ours: the key would have displaced it on insert
+static Entry* table_find(const Table* t, const char* key, size_t klen, uint64_t h,
+                         uint32_t* out_idx) {
+  uint32_t idx = idx_for(h, t->cap);
+  for (uint32_t d = 0; d < t->cap; d++) {
+    Entry* cur = SHARED_LOAD(t->slots[idx]);
+    if (cur == NULL || rh_dist(t, cur, idx) < d) return NULL;
+    if (key_eq(cur, h, key, klen)) {
+      *out_idx = idx;
+      return cur;
+    }
+    idx = (idx + 1u) & (t->cap - 1u);
+  }
+  return NULL;
+}
+
+static int table_find_ptr(const Table* t, uint64_t h, const Entry* e, uint32_t* out_idx) {
+  uint32_t idx = idx_for(h, t->cap);
+  for (uint32_t d = 0; d < t->cap; d++) {
+    Entry* cur = t->slots[idx];
+    if (cur == NULL || rh_dist(t, cur, idx) < d) return 0;
+    if (cur == e) {
+      *out_idx = idx;
+      return 1;
+    }
+    idx = (idx + 1u) & (t->cap - 1u);
+  }
+  return 0;
+}
+
+// Insert an entry whose key is known to be absent, taking the slot of any
+// entry that is closer to its home
+static int table_insert(Table* t, uint64_t h, Entry* e) {
+  uint32_t idx = idx_for(h, t->cap);
+  uint32_t d = 0;
+  for (;;) {
+    Entry* cur = t->slots[idx];
+    if (cur == NULL) {
+      SHARED_STORE(t->slots[idx], e);
+      t->used++;
+      return 1;
+    }
+    uint32_t cd = rh_dist(t, cur, idx);
+    if (cd < d) {
+      SHARED_STORE(t->slots[idx], e);
+      e = cur;
+      d = cd;
+    }
+    idx = (idx + 1u) & (t->cap - 1u);
+    d++;
+  }
+}
+
+// Backward-shift delete: pull the following displaced entries one slot
+// towards home, so no tombstone is left behind
+static void table_erase(Table* t, uint32_t idx) {
+  uint32_t next = (idx + 1u) & (t->cap - 1u);
+  while (t->slots[next] != NULL && rh_dist(t, t->slots[next], next) != 0) {
+    SHARED_STORE(t->slots[idx], t->slots[next]);
+    idx = next;
+    next = (next + 1u) & (t->cap - 1u);
+  }
+  SHARED_STORE(t->slots[idx], (Entry*)NULL);
+  t->used--;
+}
+
+static void table_clear(Table* t) {
+  table_clear_slots(t);
+}
+
+static inline int table_is_tombstone(const Table* t, uint32_t idx) {
+  (void)t;
+  (void)idx;
+  return 0;
+}
+
+static inline uint32_t table_displacement(const Table* t, uint32_t home, uint32_t idx) {
+  return (idx - home) & (t->cap - 1u);
+}
+
+#elif HINOTETSU_TABLE == HINOTETSU_TABLE_CUCKOO
+
+#define LOAD_FACTOR_NUM 19u
+#define LOAD_FACTOR_DEN 20u
+#define TABLE_CTRL_BYTES(cap) ((size_t)(cap) + TABLE_STASH)
+#define GROUP_WIDTH 4u           // slots per bucket
+#define CUCKOO_BFS_BUCKETS 256u  // buckets a cuckoo path search may visit
+#define CUCKOO_NONE UINT32_MAX
+
+// 8 bits just below the shard bits, clear of the bucket bits. 0 marks an
+// empty slot.
+static inline uint8_t tag_for(uint64_t h) {
+  uint8_t tag = (uint8_t)(h >> (56u - SHARD_BITS));
+  return tag ? tag : 1u;
+}
+
+// The other bucket of an entry follows from either bucket and its tag, so
+// paths are searched without touching the entries
+static inline uint32_t cuckoo_alt(uint32_t b, uint8_t tag, uint32_t bmask) {
+  return (b ^ ((uint32_t)tag * 0x5bd1e995u | 1u)) & bmask;
+}
+
+static inline Entry* table_at(const Table* t, uint32_t idx) {
+  return SHARED_LOAD(t->ctrl[idx]) ? SHARED_LOAD(t->slots[idx]) : NULL;
+}
+
+static inline Entry* cuckoo_scan(const Table* t, uint32_t first, uint32_t n, uint8_t tag,
+                                 const char* key, size_t klen, uint64_t h, uint32_t* out_idx) {
+  for (uint32_t idx = first; idx < first + n; idx++) {
+    if (SHARED_LOAD(t->ctrl[idx]) != tag) continue;
+    Entry* e = SHARED_LOAD(t->slots[idx]);
+    if (key_eq(e, h, key, klen)) {
+      *out_idx = idx;
+      return e;
+    }
+  }
+  return NULL;
+}
+
+// A move fills the new slot before emptying the old one, but a lock-free
+// reader may still pass an entry on its way between the two buckets
+static Entry* table_find(const Table* t, const char* key, size_t klen, uint64_t h,
+                         uint32_t* out_idx) {
+  uint32_t bmask = t->cap / GROUP_WIDTH - 1u;
+  uint8_t tag = tag_for(h);
+  uint32_t b1 = idx_for(h, bmask + 1u);
+  uint32_t b2 = cuckoo_alt(b1, tag, bmask);
+  __builtin_prefetch(t->ctrl + b2 * GROUP_WIDTH);
+  __builtin_prefetch(&t->slots[b2 * GROUP_WIDTH]);
+  Entry* e = cuckoo_scan(t, b1 * GROUP_WIDTH, GROUP_WIDTH, tag, key, klen, h, out_idx);
+  if (!e) e = cuckoo_scan(t, b2 * GROUP_WIDTH, GROUP_WIDTH, tag, key, klen, h, out_idx);
+  if (!e && SHARED_LOAD(t->stashed)) {
+    e = cuckoo_scan(t, t->cap, TABLE_STASH, tag, key, klen, h, out_idx);
+  }
+  return e;
+}
+
+static int table_find_ptr(const Table* t, uint64_t h, const Entry* e, uint32_t* out_idx) {
+  uint32_t bmask = t->cap / GROUP_WIDTH - 1u;
+  uint32_t b = idx_for(h, bmask + 1u);
+  for (int k = 0; k < 2; k++) {
+    for (uint32_t idx = b * GROUP_WIDTH; idx < (b + 1u) * GROUP_WIDTH; idx++) {
+      if (t->slots[idx] == e) {
+        *out_idx = idx;
+        return 1;
+      }
+    }
+    b = cuckoo_alt(b, tag_for(h), bmask);
+  }
+  for (uint32_t idx = t->cap; t->stashed && idx < table_span(t); idx++) {
+    if (t->slots[idx] == e) {
+      *out_idx = idx;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static inline uint32_t cuckoo_free_slot(const Table* t, uint32_t b) {
+  for (uint32_t idx = b * GROUP_WIDTH; idx < (b + 1u) * GROUP_WIDTH; idx++) {
+    if (t->ctrl[idx] == 0) return idx;
+  }
+  return CUCKOO_NONE;
+}
+
+// Slot first, then tag; emptied in the opposite order
+static inline void cuckoo_fill(Table* t, uint32_t idx, Entry* e, uint8_t tag) {
+  SHARED_STORE(t->slots[idx], e);
+  SHARED_STORE(t->ctrl[idx], tag);
+}
+
+static inline void cuckoo_empty(Table* t, uint32_t idx) {
+  SHARED_STORE(t->ctrl[idx], (uint8_t)0);
+  SHARED_STORE(t->slots[idx], (Entry*)NULL);
+}
+
+typedef struct CuckooStep {
+  uint32_t bucket;
+  uint32_t parent;  // step whose bucket the entry moving here comes from
+  uint32_t from;    // that entry's slot
+} CuckooStep;
+
+// Breadth-first search from the full buckets b1 and b2 for the shortest
+// path of entries that can each move to their other bucket, ending at a
+// free slot. The path is shifted from its far end, so every entry stays in
+// some slot throughout. Returns the slot freed in b1 or b2, CUCKOO_NONE if
+// no path is found within CUCKOO_BFS_BUCKETS buckets.
+static uint32_t cuckoo_make_room(Table* t, uint32_t b1, uint32_t b2) {
+  CuckooStep q[CUCKOO_BFS_BUCKETS];
+  uint32_t bmask = t->cap / GROUP_WIDTH - 1u;
+  q[0] = (CuckooStep){ b1, CUCKOO_NONE, CUCKOO_NONE };
+  q[1] = (CuckooStep){ b2, CUCKOO_NONE, CUCKOO_NONE };
+  uint32_t tail = b1 == b2 ? 1u : 2u;
+
+  for (uint32_t head = 0; head < tail; head++) {
+    uint32_t b = q[head].bucket;
+    for (uint32_t idx = b * GROUP_WIDTH; idx < (b + 1u) * GROUP_WIDTH; idx++) {
+      uint32_t alt = cuckoo_alt(b, t->ctrl[idx], bmask);
+      uint32_t dst = cuckoo_free_slot(t, alt);
+      if (dst != CUCKOO_NONE) {
+        uint32_t src = idx;
+        for (uint32_t n = head;; n = q[n].parent) {
+          cuckoo_fill(t, dst, t->slots[src], t->ctrl[src]);
+          cuckoo_empty(t, src);
+          dst = src;
+          if (q[n].parent == CUCKOO_NONE) return dst;
+          src = q[n].from;
+        }
+      }
+      if (tail == CUCKOO_BFS_BUCKETS) continue;
+      // A bucket may appear once per path: a second visit would move out
+      // an entry that an earlier move has already replaced
+      uint32_t p = head;
+      while (p != CUCKOO_NONE && q[p].bucket != alt) p = q[p].parent;
+      if (p == CUCKOO_NONE) q[tail++] = (CuckooStep){ alt, head, idx };
+    }
+  }
+  return CUCKOO_NONE;
+}
+
+// Insert an entry whose key is known to be absent: into either bucket,
+// making room along a cuckoo path if both are full, else into the stash
+static int table_insert(Table* t, uint64_t h, Entry* e) {
+  uint32_t bmask = t->cap / GROUP_WIDTH - 1u;
+  uint8_t tag = tag_for(h);
+  uint32_t b1 = idx_for(h, bmask + 1u);
+  uint32_t b2 = cuckoo_alt(b1, tag, bmask);
+  uint32_t idx = cuckoo_free_slot(t, b1);
+  if (idx == CUCKOO_NONE) idx = cuckoo_free_slot(t, b2);
+  if (idx == CUCKOO_NONE) idx = cuckoo_make_room(t, b1, b2);
+  if (idx == CUCKOO_NONE) {
+    for (idx = t->cap; idx < table_span(t) && t->ctrl[idx]; idx++) {}
+    if (idx == table_span(t)) return 0;
+    SHARED_STORE(t->stashed, t->stashed + 1u);
+  }
+  cuckoo_fill(t, idx, e, tag);
+  t->used++;
+  return 1;
+}
+
+static inline void table_erase(Table* t, uint32_t idx) {
+  cuckoo_empty(t, idx);
+  if (idx >= t->cap) SHARED_STORE(t->stashed, t->stashed - 1u);
+  t->used--;
+}
+
+static void table_clear(Table* t) {
+#if HINOTETSU_LOCKFREE_READS
+  for (uint32_t i = 0; i < table_span(t); i++) SHARED_STORE(t->ctrl[i], (uint8_t)0);
+#else
+  memset(t->ctrl, 0, TABLE_CTRL_BYTES(t->cap));
+#endif
+  SHARED_STORE(t->stashed, 0u);
+  table_clear_slots(t);
+}
+
+static inline int table_is_tombstone(const Table* t, uint32_t idx) {
+  (void)t;
+  (void)idx;
+  return 0;
+}
+
+// 0 in the first bucket, 1 in the other, 2 in the stash
+static inline uint32_t table_displacement(const Table* t, uint32_t home, uint32_t idx) {
+  if (idx >= t->cap) return 2u;
+  return idx / GROUP_WIDTH == home ? 0u : 1u;
+}
+
+#else  // HINOTETSU_TABLE_LINEAR
+
+#define LOAD_FACTOR_NUM 7u
+#define LOAD_FACTOR_DEN 10u
+#define TABLE_CTRL_BYTES(cap) ((size_t)0)
+#define GROUP_WIDTH 1u
+
+static inline Entry* table_at(const Table* t, uint32_t idx) {
+  Entry* e = SHARED_LOAD(t->slots[idx]);
+  return (e == TOMBSTONE_PTR) ? NULL : e;
+}
+
+static Entry* table_find(const Table* t, const char* key, size_t klen, uint64_t h,
+                         uint32_t* out_idx) {
+  uint32_t idx = idx_for(h, t->cap);
+  for (uint32_t i = 0; i < t->cap; i++) {
+    Entry* cur = SHARED_LOAD(t->slots[idx]);
+    if (cur == NULL) return NULL;
+    if (key_eq(cur, h, key, klen)) {
+      *out_idx = idx;
+      return cur;
+    }
+    idx = (idx + 1u) & (t->cap - 1u);
+  }
+  return NULL;
+}
+
+static int table_find_ptr(const Table* t, uint64_t h, const Entry* e, uint32_t* out_idx) {
+  uint32_t idx = idx_for(h, t->cap);
+  for (uint32_t i = 0; i < t->cap; i++) {
+    Entry* cur = t->slots[idx];
+    if (cur == NULL) return 0;
+    if (cur == e) {
+      *out_idx = idx;
+      return 1;
+    }
+    idx = (idx + 1u) & (t->cap - 1u);
+  }
+  return 0;
+}
+
+// Insert an entry whose key is known to be absent
+static int table_insert(Table* t, uint64_t h, Entry* e) {
+  uint32_t idx = idx_for(h, t->cap);
+  while (t->slots[idx] != NULL && t->slots[idx] != TOMBSTONE_PTR) {
+    idx = (idx + 1u) & (t->cap - 1u);
+  }
+  if (t->slots[idx] == NULL) t->used++;
+  SHARED_STORE(t->slots[idx], e);
+  return 1;
+}
+
+static inline void table_erase(Table* t, uint32_t idx) {
+  SHARED_STORE(t->slots[idx], TOMBSTONE_PTR);
+}
+
+static void table_clear(Table* t) {
+  table_clear_slots(t);
+}
+
+static inline int table_is_tombstone(const Table* t, uint32_t idx) {
+  return t->slots[idx] == TOMBSTONE_PTR;
+}
+
+static inline uint32_t table_displacement(const Table* t, uint32_t home, uint32_t idx) {
+  return (idx - home) & (t->cap - 1u);
+}
+
+#endif
+
+// huge: back the table with huge pages if it fills at least one; smaller
+// tables could not use one and would waste most of an explicit one
+static Table* table_create(uint32_t cap, int huge) {
+  size_t ctrl_bytes = (TABLE_CTRL_BYTES(cap) + 63u) & ~(size_t)63u;
+  size_t bytes = TABLE_HDR_SIZE + ctrl_bytes + ((size_t)cap + TABLE_STASH) * sizeof(Entry*);
+  Mapping map;
+
+  if (!mapping_create(&map, bytes, huge && bytes >= HUGE_PAGE_BYTES ? HUGE_ANY : HUGE_OFF, 1)) {
+    return NULL;
+  }
+
+  uint8_t* mem = map.base;
+  Table* t = (Table*)mem;
+  t->cap = cap;
+  t->map = map;
+  t->ctrl = ctrl_bytes ? mem + TABLE_HDR_SIZE : NULL;
+  t->slots = (Entry**)(mem + TABLE_HDR_SIZE + ctrl_bytes);
+  table_clear(t);
+  return t;
+}
+
+static void table_destroy(Table* t) {
+  if (!t) return;
+  Mapping map = t->map;  // t lives inside the mapping
+  mapping_destroy(&map);
+}
+
+// Batch prefetch stages for a key: its home slots (and control bytes), then
+// the entry in the first slot that can hold it
+static inline uint32_t table_home(const Table* t, uint64_t h) {
+  return idx_for(h, t->cap / GROUP_WIDTH) * GROUP_WIDTH;
+}
+
+static inline void table_prefetch_slots(const Table* t, uint64_t h) {
+  uint32_t home = table_home(t, h);
+  if (t->ctrl) __builtin_prefetch(t->ctrl + home);
+  __builtin_prefetch(&t->slots[home]);
+}
+
+static inline void table_prefetch_entry(const Table* t, uint64_t h) {
+  uint32_t idx = table_home(t, h);
+#if HINOTETSU_TABLE == HINOTETSU_TABLE_SWISS
+  GroupMask m = group_match(t->ctrl + idx, tag_for(h));
+  if (!m) return;
+  idx += mask_first(m);
+#elif HINOTETSU_TABLE == HINOTETSU_TABLE_CUCKOO
+  uint32_t end = idx + GROUP_WIDTH;
+  while (idx < end && t->ctrl[idx] != tag_for(h)) idx++;
+  if (idx == end) return;
+#endif
+  const Entry* e = table_at(t, idx);
+  if (!e) return;
+  __builtin_prefetch(e);
+  __builtin_prefetch((const char*)e + 64);  // key bytes past the header
+}
+
+// Accumulate probe diagnostics for one table. Home positions are slots for
+// LINEAR and ROBINHOOD, groups for SWISS and buckets for CUCKOO;
+// displacement is counted in the same unit.
+static void table_collect_stats(const Table* t, HinotetsuTableShardStats* st) {
+  uint32_t homes = t->cap / GROUP_WIDTH;
+  uint64_t* seen = (uint64_t*)calloc(((size_t)homes + 63u) / 64u, sizeof(uint64_t));
+
+  st->capacity += t->cap;
+  for (uint32_t idx = 0; idx < table_span(t); idx++) {
+    if (table_is_tombstone(t, idx)) {
+      st->tombstones++;
+      continue;
+    }
+    Entry* e = table_at(t, idx);
+    if (!e) continue;
+
+    uint32_t home = idx_for(e->hash, homes);
+    uint32_t d = table_displacement(t, home, idx);
+    st->live++;
+    st->probe_hist[d < HINOTETSU_PROBE_HIST ? d : HINOTETSU_PROBE_HIST - 1u]++;
+    if (d > st->max_displacement) st->max_displacement = d;
+    if (seen && !(seen[home >> 6] & (1ULL << (home & 63u)))) {
+      seen[home >> 6] |= 1ULL << (home & 63u);
+      st->home_slots++;
+    }
+  }
+  free(seen);
+}
+
+// --------- incremental resize ----------
+
+// Drop an entry that has already been removed from the tables. A pinned
+// entry is retired instead; its memory stays readable until released.
+static void entry_release(Shard* s, Entry* e) {
+  queue_unlink(s, e);
+  wheel_unlink(&s->wheel, e);
+  if (s->count) s->count--;
+  if (e->refs) {
+    e->refs |= ENTRY_RETIRED;
+    e->next = s->retired;
+    s->retired = e;
+    return;
+  }
+  entry_free(s, e);
+}
+
+// Pin an entry found under the read lock. Returns 0 if it has too many
+// references already.
+static inline int entry_pin(Shard* s, Entry* e) {
+  uint8_t v = __atomic_load_n(&e->refs, __ATOMIC_RELAXED);
+  do {
+    if (v == ENTRY_REFS) return 0;
+  } while (!__atomic_compare_exchange_n(&e->refs, &v, (uint8_t)(v + 1u), 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+  if (v == 0) {
+    __atomic_add_fetch(&page_of(s, e)->pinned, 1u, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s->pinned, 1u, __ATOMIC_RELAXED);
+  }
+  return 1;
+}
+
+// Drop a reference under the read lock. Returns 1 if the entry is retired
+// and this was its last reference, so shard_reap() has work to do.
+static inline int entry_unpin(Shard* s, Entry* e) {
+  uint8_t v = __atomic_sub_fetch(&e->refs, 1u, __ATOMIC_RELAXED);
+  if ((v & ENTRY_REFS) != 0) return 0;
+  __atomic_sub_fetch(&page_of(s, e)->pinned, 1u, __ATOMIC_RELAXED);
+  __atomic_sub_fetch(&s->pinned, 1u, __ATOMIC_RELAXED);
+  return v == ENTRY_RETIRED;
+}
+
+// Free retired entries whose last reference is gone (write lock held)
+static void shard_reap(Shard* s) {
+  Entry** pp = &s->retired;
+  while (*pp) {
+    Entry* e = *pp;
+    if (e->refs != ENTRY_RETIRED) {
+      pp = &e->next;
+      continue;
+    }
+    *pp = e->next;
+    entry_free(s, e);
+  }
+}
+
+static inline uint32_t load_limit(uint32_t cap) {
+  return (uint32_t)((uint64_t)cap * LOAD_FACTOR_NUM / LOAD_FACTOR_DEN);
+}
+
+// Start incremental resize to new_cap: larger to grow, smaller to shrink, or
+// the same size to rehash without tombstones
+static void shard_start_resize(Shard* s, uint32_t new_cap) {
+  if (s->new_tab) return;  // already resizing
+
+  if (new_cap < HINOTETSU_INIT_CAP) new_cap = HINOTETSU_INIT_CAP;
+
+  Table* nt = table_create(new_cap, s->huge_tables);
+  if (!nt) return;
+
+  SHARED_STORE(s->new_tab, nt);
+  s->migrate_pos = 0;
+}
+
+// Migrate a batch of entries from old to new table. Returns 0 if the new
+// table has no room for the next entry.
+static int shard_migrate_batch(Shard* s) {
+  if (!s->new_tab) return 1;
+
+  uint64_t now = shard_now(s);
+  uint32_t migrated = 0;
+  uint32_t scanned = 0;
+
+  // Empty slots count against a budget too, so a sparse table being shrunk
+  // is not scanned in one go
+  while (s->migrate_pos < table_span(s->tab) && migrated < HINOTETSU_MIGRATE_BATCH &&
+         scanned++ < HINOTETSU_MIGRATE_BATCH * 8u) {
+    uint32_t pos = s->migrate_pos;
+    Entry* e = table_at(s->tab, pos);
+    if (!e) {
+      s->migrate_pos++;
+      continue;
+    }
+
+    // Inserted before it is erased: an entry the new table has no room for
+    // (CUCKOO only) stays where it is, and the resize waits on it
+    int expired = is_expired(e, now);
+    if (!expired && !table_insert(s->new_tab, e->hash, e)) return 0;
+
+    // Every entry lives in exactly one table, so it can be released safely.
+    // A backward-shift erase may refill pos; stay on it until it is empty so
+    // every slot below migrate_pos stays empty.
+    table_erase(s->tab, pos);
+    if (!table_at(s->tab, pos)) s->migrate_pos++;
+    if (expired) {
+      entry_release(s, e);
+      s->reclaimed++;
+      continue;
+    }
+    migrated++;
+  }
+
+  // Check if migration complete
+  if (s->migrate_pos >= table_span(s->tab)) {
+    Table* old = s->tab;
+    SHARED_STORE(s->tab, s->new_tab);
+    SHARED_STORE(s->new_tab, (Table*)NULL);
+    s->migrate_pos = 0;
+    shard_grace(s);
+    table_destroy(old);
+  }
+  return 1;
+}
+
+// Check if a resize is needed and handle migration. Called before every
+// write, so shrinking follows deletes and expiry as well as growth.
+static void shard_maybe_resize(Shard* s) {
+  if (s->new_tab) {
+    // A shrink or purge target can fill up if writes outpace migration;
+    // finish the old table first and size again from the live count
+    if (s->new_tab->used + 1u <= load_limit(s->new_tab->cap)) {
+      shard_migrate_batch(s);
+      return;
+    }
+    while (s->new_tab && shard_migrate_batch(s)) {}
+    if (s->new_tab) return;
+  }
+
+  Table* t = s->tab;
+  uint32_t limit = load_limit(t->cap);
+  // A CUCKOO table stashes entries once it is nearly full: grow then too
+  if (t->used + 1u > limit || (t->stashed && t->used * 2u > limit)) {
+    // Mostly tombstones: a same-size rehash frees the space
+    shard_start_resize(s, (s->count + 1u) * 2u <= limit ? t->cap : t->cap << 1u);
+  } else if (t->cap > HINOTETSU_INIT_CAP && s->count < limit / 8u) {
+    // Shrink until the live entries fill about half the load limit
+    uint32_t new_cap = t->cap;
+    while (new_cap > HINOTETSU_INIT_CAP && (s->count + 1u) * 2u <= load_limit(new_cap >> 1)) {
+      new_cap >>= 1;
+    }
+    shard_start_resize(s, new_cap);
+  }
+  if (s->new_tab) shard_migrate_batch(s);
+}
+
+// Find key - searches the new table first during resize.
+// Returns the entry (possibly expired) and the table/slot holding it.
+static Entry* shard_lookup(Shard* s, uint64_t h, const char* key, size_t klen,
+                           Table** out_tab, uint32_t* out_idx) {
+  // new_tab first: an entry moves out of tab only into it, and tab only
+  // changes once new_tab is done
+  Table* nt = SHARED_LOAD(s->new_tab);
+  Table* t = SHARED_LOAD(s->tab);
+  Entry* e = nt ? table_find(nt, key, klen, h, out_idx) : NULL;
+  if (e) {
+    *out_tab = nt;
+    return e;
+  }
+  e = table_find(t, key, klen, h, out_idx);
+  if (e) *out_tab = t;
+  return e;
+}
+
+// Lookup for the read paths. Without the lock a probe can race a writer
+// moving entries about, so a miss only stands if no write overlapped it.
+static Entry* shard_find(Shard* s, uint64_t h, const char* key, size_t klen) {
+  Table* tab = NULL;
+  uint32_t idx = 0;
+  if (!HINOTETSU_LOCKFREE_READS) return shard_lookup(s, h, key, klen, &tab, &idx);
+  for (;;) {
+    uint32_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+    Entry* e = shard_lookup(s, h, key, klen, &tab, &idx);
+    if (e) return e;
+    uint32_t now = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+    if ((seq & 1u) == 0 && now == seq) return NULL;
+    shard_read_wait(s, now);
+  }
+}
+
+// --------- eviction ----------
+
+// Remove an entry whose slot is not known from whichever table holds it
+static void shard_erase_entry(Shard* s, Entry* e) {
+  uint64_t h = e->hash;
+  uint32_t idx = 0;
+  if (s->new_tab && table_find_ptr(s->new_tab, h, e, &idx)) {
+    table_erase(s->new_tab, idx);
+  } else if (table_find_ptr(s->tab, h, e, &idx)) {
+    table_erase(s->tab, idx);
+  }
+}
+
+static int shard_evict_one(Shard* s, EntryQueue* q) {
+  if (HINOTETSU_EVICTION == HINOTETSU_EVICT_NONE) return 0;
+
+  uint64_t now = shard_now(s);
+  Entry* victim = queue_pick_victim(s, q, now);
+  if (!victim) return 0;
+
+  shard_erase_entry(s, victim);
+  if (is_expired(victim, now)) s->reclaimed++;
+  else s->evictions++;
+  entry_release(s, victim);
+  return 1;
+}
+
+// Evict another shard's large values, oldest first, until one of its chunks
+// is idle and goes back to the arena. The caller holds both shards' locks.
+// Returns 1 if a chunk went back.
+static int shard_chunk_surrender(Shard* v) {
+  uint32_t budget = HINOTETSU_EVICT_TRIES;
+  for (;;) {
+    if (v->spare_chunk != ARENA_NONE) {
+      shard_chunk_return(v, v->spare_chunk);
+      return 1;
+    }
+    if (budget == 0 || !shard_evict_one(v, &v->large_queue)) return 0;
+    budget--;
+    shard_reclaim(v, 1);  // the victim waits in limbo for readers
+  }
+}
+
+// For a shard with nothing left of its own to evict: take a chunk from the
+// others in turn, so which shard a key hashes to does not decide whether
+// it fits. Peers busy with a write are skipped. Returns 1 on success.
+static int shard_evict_peers(Shard* s) {
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    uint32_t id = (s->evict_peer + i) % HINOTETSU_SHARDS;
+    Shard* v = shard_peer(s, id);
+    if (v == s || !shard_write_trylock(v)) continue;
+    int got = shard_chunk_surrender(v);
+    shard_write_unlock(v);
+    if (got) {
+      s->evict_peer = id + 1u;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// --------- slab mover ----------
+// Copy an entry into a free chunk of its class and repoint the table slot,
+// the eviction queue and the timing wheel at the copy
+static void entry_relocate(Shard* s, Entry* e) {
+  uint8_t cls = e->eclass;
+  SlabNode* n = s->freelist[cls];
+  s->freelist[cls] = n->next;
+  s->slab[cls].free--;
+
+  Entry* ne = (Entry*)n;
+  memcpy(ne, e, entry_chunk_request(e));
+  page_of(s, ne)->used++;
+  page_of(s, e)->used--;
+
+  uint32_t idx = 0;
+  if (s->new_tab && table_find_ptr(s->new_tab, e->hash, e, &idx)) {
+    SHARED_STORE(s->new_tab->slots[idx], ne);
+  } else if (table_find_ptr(s->tab, e->hash, e, &idx)) {
+    SHARED_STORE(s->tab->slots[idx], ne);
+  }
+
+  EntryQueue* q = entry_queue(s, ne);
+  if (ne->prev) ne->prev->next = ne;
+  else q->head = ne;
+  if (ne->next) ne->next->prev = ne;
+  else q->tail = ne;
+  if (q->hand == e) q->hand = ne;
+
+  if (ne->wpprev) {
+    *ne->wpprev = ne;
+    if (ne->wnext) ne->wnext->wpprev = &ne->wnext;
+  }
+}
+
+// Empty a slab page and put it on the shard's free page list. Live entries
+// move to free chunks elsewhere in the class, or are evicted once those run
+// out. Pages holding out-of-line values are left alone: a value chunk does
+// not know its owner. So are pages with pinned entries.
+static int slab_page_evacuate(Shard* s, uint32_t idx) {
+  shard_reclaim(s, 1);  // entries in limbo would pass for live ones
+  SlabPage* pg = &s->arena->pages[idx];
+  if (pg->kind != PAGE_CLASS || pg->values != 0 || pg->pinned != 0) return 0;
+
+  uint8_t cls = pg->cls;
+  size_t bsz = class_size(s, cls);
+  uint32_t per = (uint32_t)(SLAB_PAGE_BYTES / bsz);
+  uint32_t spare = s->slab[cls].free - (per - pg->used);
+  if (HINOTETSU_EVICTION == HINOTETSU_EVICT_NONE && spare < pg->used) return 0;
+
+  // Pull the page's free chunks off the freelist, noting which they are
+  uint8_t* base = page_base(s, idx);
+  uint64_t is_free[(SLAB_PAGE_MAX_CHUNKS + 63u) / 64u];
+  memset(is_free, 0, sizeof(is_free));
+  SlabNode** pp = &s->freelist[cls];
+  while (*pp) {
+    uint8_t* p = (uint8_t*)*pp;
+    if (p >= base && p < base + SLAB_PAGE_BYTES) {
+      size_t i = (size_t)(p - base) / bsz;
+      is_free[i / 64u] |= 1ULL << (i % 64u);
+      *pp = (*pp)->next;
+      s->slab[cls].free--;
+    } else {
+      pp = &(*pp)->next;
+    }
+  }
+
+  // Every other chunk holds an entry. Their chunks are reused as soon as
+  // the page is: wait out lock-free readers before then.
+  // Nor may a relocation land in a value chunk an eviction just freed.
+  uint64_t now = shard_now(s);
+  int evicting = 0;
+  s->free_now = 1;
+  for (uint32_t i = 0; i < per && pg->used; i++) {
+    if ((is_free[i / 64u] >> (i % 64u)) & 1u) continue;
+    Entry* e = (Entry*)(base + (size_t)i * bsz);
+    if (s->freelist[cls] && !(HINOTETSU_LOCKFREE_READS && evicting)) {
+      entry_relocate(s, e);
+      continue;
+    }
+    evicting = 1;
+    shard_erase_entry(s, e);
+    if (is_expired(e, now)) s->reclaimed++;
+    else s->evictions++;
+    entry_release(s, e);
+    // The entry's chunk went back to the head of the freelist
+    s->freelist[cls] = s->freelist[cls]->next;
+    s->slab[cls].free--;
+  }
+  s->free_now = 0;
+  shard_grace_release(s);
+
+  s->slab[cls].pages--;
+  s->slab[cls].chunks -= per;
+  page_free_push(s, idx);
+  return 1;
+}
+
+// The page of cls with the fewest chunks in use, SLAB_PAGE_NONE if none
+static uint32_t slab_page_pick(Shard* s, uint8_t cls) {
+  const Arena* a = s->arena;
+  uint32_t best = SLAB_PAGE_NONE;
+  for (uint32_t c = s->chunk_head; c != ARENA_NONE; c = a->chunks[c].next) {
+    for (uint32_t i = c * a->pages_per_chunk; i < (c + 1u) * a->pages_per_chunk; i++) {
+      const SlabPage* pg = &a->pages[i];
+      if (pg->kind != PAGE_CLASS || pg->cls != cls || pg->values != 0 || pg->pinned != 0) continue;
+      if (best == SLAB_PAGE_NONE || pg->used < a->pages[best].used) best = i;
+    }
+  }
+  return best;
+}
+
+// Evacuate the emptiest page of the class holding the most pages, other
+// than keep, for a class that starves while every page is busy. Returns 1
+// if a page went to the free page list.
+static int slab_page_steal(Shard* s, uint8_t keep) {
+  const Arena* a = s->arena;
+  uint32_t best[HINOTETSU_SLAB_MAX_CLASSES];
+  for (uint32_t c = 0; c < s->classes->count; c++) best[c] = SLAB_PAGE_NONE;
+  for (uint32_t c = s->chunk_head; c != ARENA_NONE; c = a->chunks[c].next) {
+    for (uint32_t i = c * a->pages_per_chunk; i < (c + 1u) * a->pages_per_chunk; i++) {
+      const SlabPage* pg = &a->pages[i];
+      if (pg->kind != PAGE_CLASS || pg->cls == keep || pg->values != 0 || pg->pinned != 0 ||
+          s->slab[pg->cls].pages < 2u) continue;
+      if (best[pg->cls] == SLAB_PAGE_NONE || pg->used < a->pages[best[pg->cls]].used) best[pg->cls] = i;
+    }
+  }
+
+  int src = -1;
+  for (uint32_t c = 0; c < s->classes->count; c++) {
+    if (best[c] == SLAB_PAGE_NONE) continue;
+    if (src < 0 || s->slab[c].pages > s->slab[src].pages) src = (int)c;
+  }
+  return src >= 0 && slab_page_evacuate(s, best[src]);
+}
+
+// Move one page from src (or, if negative, the class with the most free
+// chunks) to dst. Returns 1 if a page moved.
+static int shard_slab_reassign(Shard* s, int src, uint8_t dst) {
+  if (src < 0) {
+    uint32_t most = 0;
+    for (uint32_t c = 0; c < s->classes->count; c++) {
+      if (c == dst || s->slab[c].pages == 0 || s->slab[c].free <= most) continue;
+      most = s->slab[c].free;
+      src = (int)c;
+    }
+    if (src < 0) return 0;
+  }
+
+  uint32_t idx = slab_page_pick(s, (uint8_t)src);
+  if (idx == SLAB_PAGE_NONE || !slab_page_evacuate(s, idx)) return 0;
+  slab_refill(s, dst);  // usually takes the page just freed
+  return 1;
+}
+
+// Automatic policy: give the class that starved most since the last pass
+// the emptiest page of any other class, if that page is mostly free. Once
+// the cache is full no page is: the largest other class then gives up its
+// emptiest page anyway, evicting what cannot move, so a shift in the value
+// size mix is followed. When large values starve, the page is left on the
+// free page list for spans.
+static int shard_slab_automove(Shard* s) {
+  uint8_t dst = VALUE_CLASS_LARGE;
+  uint32_t worst = s->large_starved;
+  s->large_starved = 0;
+  for (uint32_t c = 0; c < s->classes->count; c++) {
+    if (s->slab[c].starved > worst) {
+      worst = s->slab[c].starved;
+      dst = (uint8_t)c;
+    }
+    s->slab[c].starved = 0;
+  }
+  if (worst == 0) return 0;
+
+  const Arena* a = s->arena;
+  uint32_t best = SLAB_PAGE_NONE;
+  uint64_t best_used = 0, best_per = 1;
+  for (uint32_t c = s->chunk_head; c != ARENA_NONE; c = a->chunks[c].next) {
+    for (uint32_t i = c * a->pages_per_chunk; i < (c + 1u) * a->pages_per_chunk; i++) {
+      const SlabPage* pg = &a->pages[i];
+      if (pg->kind != PAGE_CLASS || pg->cls == dst || pg->values != 0 || pg->pinned != 0 ||
+          s->slab[pg->cls].pages < 2u) continue;
+      uint64_t per = SLAB_PAGE_BYTES / class_size(s, pg->cls);
+      if (pg->used * 100u > per * HINOTETSU_SLAB_AUTOMOVE_USED_PCT) continue;
+      if (best == SLAB_PAGE_NONE || pg->used * best_per < best_used * per) {
+        best = i;
+        best_used = pg->used;
+        best_per = per;
+      }
+    }
+  }
+  if (best == SLAB_PAGE_NONE) {
+    if (!slab_page_steal(s, dst)) return 0;
+  } else if (!slab_page_evacuate(s, best)) {
+    return 0;
+  }
+  if (dst != VALUE_CLASS_LARGE) slab_refill(s, dst);
+  return 1;
+}
+
+// Turn the shard's timing wheel up to now_ms, freeing at most max_items due
+// entries. A step that runs out of budget resumes in the same second next
+// time. Returns the number of entries freed.
+static uint32_t shard_expire(Shard* s, uint64_t now_ms, uint32_t max_items) {
+  TimerWheel* w = &s->wheel;
+  uint32_t now = (uint32_t)(now_ms / 1000u);
+  uint32_t freed = 0;
+
+  while (w->now <= now) {
+    if (w->items == 0) {
+      w->now = now + 1u;
+      break;
+    }
+
+    // On a level boundary, pull the next slot of each higher level down
+    for (uint32_t l = WHEEL_LEVELS - 1u; l >= 1u; l--) {
+      uint32_t span_mask = (1u << (WHEEL_BITS * l)) - 1u;
+      if ((w->now & span_mask) != 0u) continue;
+      if (l == WHEEL_LEVELS - 1u) wheel_cascade(w, &w->overflow);
+      wheel_cascade(w, &w->slot[l][(w->now >> (WHEEL_BITS * l)) & (WHEEL_SLOTS - 1u)]);
+    }
+
+    Entry** due = &w->slot[0][w->now & (WHEEL_SLOTS - 1u)];
+    while (*due) {
+      if (freed == max_items) return freed;
+      Entry* e = *due;
+      shard_erase_entry(s, e);
+      entry_release(s, e);
+      s->reclaimed++;
+      freed++;
+    }
+    w->now++;
+  }
+  return freed;
+}
+
+// Create an entry, evicting entries of the size class that ran dry until it
+// has a free chunk. When no extent fits a large value, entries holding
+// extents are evicted one at a time until freed neighbours merge into room.
+// A class with nothing left to evict takes a page from another class, so
+// memory held by one value size does not lock out the others. A shard that
+// runs out of victims takes chunks from the other shards.
+static Entry* entry_create_evicting(Shard* s,
+                                    const char* key, size_t klen,
+                                    const char* val, size_t vlen,
+                                    uint64_t ttl_ms) {
+  uint32_t budget = HINOTETSU_EVICT_TRIES;
+  uint32_t peer_budget = HINOTETSU_SHARDS;
+  int evicted = 0;
+  for (;;) {
+    // Victims' memory is handed out right away: wait out readers first
+    if (evicted) shard_grace_release(s);
+    evicted = 0;
+
+    uint8_t failed = VALUE_CLASS_NONE;
+    Entry* e = entry_create_in_pool(s, key, klen, val, vlen, ttl_ms, &failed);
+    if (e || failed == VALUE_CLASS_NONE) return e;
+
+    // Entries freed lately may do before anything is evicted
+    if (s->limbo_count) {
+      shard_reclaim(s, 1);
+      continue;
+    }
+
+    int ok = 1;
+    s->free_now = 1;
+    if (failed == VALUE_CLASS_LARGE) {
+      s->large_starved++;
+      ok = budget != 0 && shard_evict_one(s, &s->large_queue);
+      evicted = ok;
+      if (!ok && budget != 0) {
+        // The page goes on the free page list for a span
+        ok = slab_page_steal(s, VALUE_CLASS_LARGE);
+        s->free_now = 1;
+      }
+      if (ok) budget--;
+    } else {
+      s->slab[failed].starved++;
+      while (s->freelist[failed] == NULL) {
+        if (budget == 0) {
+          ok = 0;
+          break;
+        }
+        budget--;
+        if (shard_evict_one(s, &s->queue[failed])) {
+          evicted = 1;
+          continue;
+        }
+        ok = slab_page_steal(s, failed);
+        s->free_now = 1;
+        if (!ok) break;
+        slab_refill(s, failed);
+      }
+    }
+    s->free_now = 0;
+    if (!ok && peer_budget != 0 && shard_evict_peers(s)) {
+      peer_budget--;
+      ok = 1;
+    }
+    if (!ok) {
+      if (evicted) shard_grace_release(s);
+      return NULL;
+    }
+  }
+}
+
+// ==================== INTERNAL (no lock) ====================
+
+static int set_internal(Shard* s, uint64_t h,
+                        const char* key, size_t klen,
+                        const char* value, size_t vlen,
+                        uint64_t ttl_ms) {
+  // Do migration work
+  shard_maybe_resize(s);
+
+  shard_expire(s, shard_now(s), HINOTETSU_RECLAIM_BATCH);
+  if (s->limbo_count >= LIMBO_BATCH) shard_reclaim(s, 0);
+
+  // Create the new entry first, so a failed overwrite keeps the old value
+  Entry* e = entry_create_evicting(s, key, klen, value, vlen, ttl_ms);
+  if (!e) return HINOTETSU_ERR_NOMEM;
+  e->hash = h;
+
+  // Look the key up only now: making room may have evicted or moved the
+  // existing entry. It shares the hash, so the new one takes its slot.
+  Table* tab = NULL;
+  uint32_t idx = 0;
+  Entry* existing = shard_lookup(s, h, key, klen, &tab, &idx);
+  if (existing) {
+    SHARED_STORE(tab->slots[idx], e);
+    entry_release(s, existing);
+  } else if (!table_insert(s->new_tab ? s->new_tab : s->tab, h, e)) {
+    entry_free(s, e);
+    return HINOTETSU_ERR_NOMEM;
+  }
+  queue_push_head(s, e);
+  if (e->expire) wheel_add(&s->wheel, e);
+  s->count++;
+  return HINOTETSU_OK;
+}
+
+static int get_into_internal(Shard* s, uint64_t h,
+                             const char* key, size_t klen,
+                             char* dst, size_t dst_cap,
+                             size_t* out_vlen) {
+  Entry* e = shard_find(s, h, key, klen);
+  if (!e || is_expired(e, shard_now(s))) {
+    read_miss(s);
+    return HINOTETSU_ERR_NOTFOUND;
+  }
+
+  read_hit(s);
+  entry_touch(s, e);
+  *out_vlen = e->vlen;
+  if (e->vlen > dst_cap) return HINOTETSU_ERR_TOOSMALL;
+
+  memcpy(dst, entry_value(e), e->vlen);
+  return HINOTETSU_OK;
+}
+
+static int delete_internal(Shard* s, uint64_t h, const char* key, size_t klen) {
+  shard_maybe_resize(s);
+
+  uint64_t now = shard_now(s);
+  Table* tab = NULL;
+  uint32_t idx = 0;
+  Entry* e = shard_lookup(s, h, key, klen, &tab, &idx);
+  if (!e) return HINOTETSU_ERR_NOTFOUND;
+
+  // An expired entry is still reclaimed, but reported as missing
+  int expired = is_expired(e, now);
+  table_erase(tab, idx);
+  entry_release(s, e);
+  shard_expire(s, now, HINOTETSU_RECLAIM_BATCH);
+  if (s->limbo_count >= LIMBO_BATCH) shard_reclaim(s, 0);
+  if (expired) {
+    s->reclaimed++;
+    return HINOTETSU_ERR_NOTFOUND;
+  }
+  return HINOTETSU_OK;
+}
+
+// --------- flat combining ----------
+static int fc_run(Shard* s, const FcSlot* op) {
+  if (op->op == FC_DELETE) return delete_internal(s, op->hash, op->key, op->klen);
+  return set_internal(s, op->hash, op->key, op->klen, op->value, op->vlen, op->ttl_ms);
+}
+
+// Run the ops published so far, and those published meanwhile for a few
+// rounds (write lock held)
+static void fc_combine(Shard* s) {
+  for (uint32_t pass = 0; pass < FC_PASSES; pass++) {
+    uint64_t m = __atomic_exchange_n(&s->fc_pending, 0u, __ATOMIC_ACQUIRE);
+    if (!m) return;
+    for (; m; m &= m - 1u) {
+      FcSlot* f = &s->fc[__builtin_ctzll(m)];
+      f->ret = fc_run(s, f);
+      s->combined++;
+      __atomic_store_n(&f->state, FC_DONE, __ATOMIC_RELEASE);
+    }
+  }
+}
+
+// Publish op in this thread's slot and wait until a lock holder has run
+// it, taking the lock whenever it comes free. Returns 0 if another thread
+// sharing the slot has it.
+static int fc_publish(Shard* s, const FcSlot* op, int* ret) {
+  uint32_t i = thread_slot();
+  FcSlot* f = &s->fc[i];
+  uint32_t free_state = FC_FREE;
+  if (!__atomic_compare_exchange_n(&f->state, &free_state, FC_BUSY, 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    return 0;
+  }
+  f->op = op->op;
+  f->hash = op->hash;
+  f->key = op->key;
+  f->klen = op->klen;
+  f->value = op->value;
+  f->vlen = op->vlen;
+  f->ttl_ms = op->ttl_ms;
+  __atomic_fetch_or(&s->fc_pending, 1ULL << i, __ATOMIC_RELEASE);
+
+  while (__atomic_load_n(&f->state, __ATOMIC_ACQUIRE) != FC_DONE) {
+    if (shard_write_trylock(s)) {
+      fc_combine(s);  // ours is among them
+      shard_write_unlock(s);
+    } else {
+      sched_yield();
+    }
+  }
+  *ret = f->ret;
+  __atomic_store_n(&f->state, FC_FREE, __ATOMIC_RELEASE);
+  return 1;
+}
+
+// A SET or DELETE under the shard write lock, or with combining handed to
+// whoever holds it
+static int shard_write(Shard* s, const FcSlot* op) {
+  int ret;
+  int locked = s->fc && shard_write_trylock(s);
+  if (!locked && s->fc && fc_publish(s, op, &ret)) return ret;
+  if (!locked) shard_write_lock(s);
+  ret = fc_run(s, op);
+  if (s->fc) fc_combine(s);
+  shard_write_unlock(s);
+  return ret;
+}
+
+static int get_ref_internal(Shard* s, uint64_t h,
+                            const char* key, size_t klen,
+                            HinotetsuRef* ref) {
+  Entry* e = shard_find(s, h, key, klen);
+  if (!e || is_expired(e, shard_now(s))) {
+    read_miss(s);
+    return HINOTETSU_ERR_NOTFOUND;
+  }
+
+  read_hit(s);
+  entry_touch(s, e);
+  ref->vlen = e->vlen;
+  if (entry_pin(s, e)) {
+    ref->value = entry_value(e);
+    ref->handle = e;
+    return HINOTETSU_OK;
+  }
+
+  // Out of references on this entry: hand out a private copy
+  char* copy = (char*)malloc(e->vlen ? e->vlen : 1u);
+  if (!copy) return HINOTETSU_ERR_NOMEM;
+  memcpy(copy, entry_value(e), e->vlen);
+  ref->value = copy;
+  ref->handle = NULL;
+  return HINOTETSU_OK;
+}
+
+// Copy a value into a buffer of its own size
+static int get_alloc_internal(Shard* s, uint64_t h,
+                              const char* key, size_t klen,
+                              char** out_value, size_t* out_vlen) {
+  Entry* e = shard_find(s, h, key, klen);
+  if (!e || is_expired(e, shard_now(s))) {
+    read_miss(s);
+    return HINOTETSU_ERR_NOTFOUND;
+  }
+
+  read_hit(s);
+  entry_touch(s, e);
+  char* buf = (char*)malloc(e->vlen ? e->vlen : 1u);
+  if (!buf) return HINOTETSU_ERR_NOMEM;
+  memcpy(buf, entry_value(e), e->vlen);
+  *out_value = buf;
+  *out_vlen = e->vlen;
+  return HINOTETSU_OK;
+}
+
+// Drop every entry. With references outstanding the entries are released
+// one at a time, so pinned ones are retired rather than recycled with the
+// shard's memory.
+static void shard_flush(Shard* s) {
+  int pinned = __atomic_load_n(&s->pinned, __ATOMIC_RELAXED) != 0;
+  if (pinned) {
+    Table* tabs[2] = { s->tab, s->new_tab };
+    for (int t = 0; t < 2; t++) {
+      if (!tabs[t]) continue;
+      for (uint32_t idx = 0; idx < table_span(tabs[t]); idx++) {
+        Entry* e = table_at(tabs[t], idx);
+        if (e) entry_release(s, e);
       }
-      idx = (idx + 1u) & (cap - 1u);
     }
   }
 
-  // Search old table
-  uint32_t cap = s->cap;
-  uint32_t idx = idx_for(h, cap);
-  uint32_t first_tomb = UINT32_MAX;
+  Table* nt = s->new_tab;
+  table_clear(s->tab);
+  SHARED_STORE(s->new_tab, (Table*)NULL);
+  s->migrate_pos = 0;
+  s->count = 0;
+  s->evictions = 0;
+  s->reclaimed = 0;
+  s->combined = 0;
+  // Lock-free readers may still be in the tables or the entries
+  shard_grace(s);
+  table_destroy(nt);
+  if (pinned) return;
+
+  s->item_bytes = 0;
+  s->retired = NULL;
+  memset(s->limbo, 0, sizeof(s->limbo));
+  s->limbo_count = 0;
+  memset(s->queue, 0, sizeof(s->queue));
+  wheel_reset(&s->wheel, (uint32_t)(shard_now(s) / 1000u));
+  slab_reset(s);
+}
 
-  for (;;) {
-    Entry* cur = s->tab[idx];
-    if (cur == NULL) {
-      *found = 0;
-      *out_tab = s->new_tab ? &s->new_tab : &s->tab;
-      *out_cap = s->new_tab ? s->new_cap : s->cap;
-      return (first_tomb != UINT32_MAX) ? first_tomb : idx_for(h, *out_cap);
-    }
-    if (cur == TOMBSTONE_PTR) {
-      if (first_tomb == UINT32_MAX) first_tomb = idx;
-    } else if (key_eq(cur, key, klen)) {
-      *found = 1;
-      *out_tab = &s->tab;
-      *out_cap = s->cap;
-      return idx;
-    }
-    idx = (idx + 1u) & (cap - 1u);
+// --------- batches ----------
+// Keys of a batch are hashed up front and grouped by shard, so each shard
+// lock is taken once. Within a shard's run the slots of the key two places
+// ahead and the entry of the next key are prefetched while the current
+// key is looked up.
+#define BATCH_STACK_KEYS 256u
+#define BATCH_SKIP HINOTETSU_SHARDS  // shard of a key left out of the batch
+
+typedef struct BatchPlan {
+  uint64_t* hash;
+  uint32_t* shard;
+  uint32_t* order;  // key indices, grouped by shard
+  uint32_t start[HINOTETSU_SHARDS + 1u];
+  void* heap;
+  uint64_t hash_buf[BATCH_STACK_KEYS];
+  uint32_t shard_buf[BATCH_STACK_KEYS];
+  uint32_t order_buf[BATCH_STACK_KEYS];
+} BatchPlan;
+
+static int batch_plan_init(BatchPlan* p, size_t n) {
+  p->heap = NULL;
+  if (n <= BATCH_STACK_KEYS) {
+    p->hash = p->hash_buf;
+    p->shard = p->shard_buf;
+    p->order = p->order_buf;
+    return 1;
   }
+  if (n > UINT32_MAX) return 0;
+  p->heap = malloc(n * (sizeof(uint64_t) + 2u * sizeof(uint32_t)));
+  if (!p->heap) return 0;
+  p->hash = (uint64_t*)p->heap;
+  p->shard = (uint32_t*)(p->hash + n);
+  p->order = p->shard + n;
+  return 1;
 }
 
-// Simplified find for insert (always into newest table)
-static uint32_t find_insert_slot(Entry** tab, uint32_t cap, const char* key, size_t klen, uint64_t h, int* found) {
-  uint32_t idx = idx_for(h, cap);
-  uint32_t first_tomb = UINT32_MAX;
+static void batch_plan_free(BatchPlan* p) {
+  free(p->heap);
+}
 
-  for (;;) {
-    Entry* cur = tab[idx];
-    if (cur == NULL) {
-      *found = 0;
-      return (first_tomb != UINT32_MAX) ? first_tomb : idx;
-    }
-    if (cur == TOMBSTONE_PTR) {
-      if (first_tomb == UINT32_MAX) first_tomb = idx;
-    } else if (key_eq(cur, key, klen)) {
-      *found = 1;
-      return idx;
+// Hash the keys; empty ones are left out with HINOTETSU_ERR_IO
+static void batch_plan_keys(BatchPlan* p, const char* const* keys, const size_t* klens,
+                            size_t n, int* results) {
+  for (size_t i = 0; i < n; i++) {
+    if (!keys[i] || klens[i] == 0) {
+      p->shard[i] = BATCH_SKIP;
+      if (results) results[i] = HINOTETSU_ERR_IO;
+      continue;
     }
-    idx = (idx + 1u) & (cap - 1u);
+    p->hash[i] = key_hash(keys[i], klens[i]);
+    p->shard[i] = shard_id_for(p->hash[i]);
   }
 }
 
-// ==================== INTERNAL (no lock) ====================
-
-static int set_internal(Shard* s, uint64_t h,
-                        const char* key, size_t klen,
-                        const char* value, size_t vlen,
-                        uint32_t ttl_seconds) {
-  // Do migration work
-  shard_maybe_grow(s);
-
-  // Determine target table
-  Entry** target_tab = s->new_tab ? s->new_tab : s->tab;
-  uint32_t target_cap = s->new_tab ? s->new_cap : s->cap;
-  uint32_t* target_used = s->new_tab ? &s->new_used : &s->used;
-
-  // Check both tables for existing key
-  int found_old = 0, found_new = 0;
-  uint32_t idx_old = 0, idx_new = 0;
+// Counting sort of the key indices by shard
+static void batch_plan_group(BatchPlan* p, size_t n) {
+  memset(p->start, 0, sizeof(p->start));
+  for (size_t i = 0; i < n; i++) {
+    if (p->shard[i] != BATCH_SKIP) p->start[p->shard[i] + 1u]++;
+  }
+  for (uint32_t sh = 0; sh < HINOTETSU_SHARDS; sh++) p->start[sh + 1u] += p->start[sh];
+  uint32_t fill[HINOTETSU_SHARDS];
+  memcpy(fill, p->start, sizeof(fill));
+  for (size_t i = 0; i < n; i++) {
+    if (p->shard[i] != BATCH_SKIP) p->order[fill[p->shard[i]]++] = (uint32_t)i;
+  }
+}
 
+static inline void shard_prefetch(const Shard* s, uint64_t h, int entry) {
   if (s->new_tab) {
-    idx_new = find_insert_slot(s->new_tab, s->new_cap, key, klen, h, &found_new);
-  }
-  idx_old = find_insert_slot(s->tab, s->cap, key, klen, h, &found_old);
-
-  // Update existing entry if found
-  Entry* existing = NULL;
-  Entry** existing_tab = NULL;
-  uint32_t existing_idx = 0;
-
-  if (found_new) {
-    existing = s->new_tab[idx_new];
-    existing_tab = s->new_tab;
-    existing_idx = idx_new;
-  } else if (found_old) {
-    existing = s->tab[idx_old];
-    existing_tab = s->tab;
-    existing_idx = idx_old;
-  }
-
-  if (existing && existing != TOMBSTONE_PTR) {
-    uint8_t new_class = VALUE_CLASS_BUMP;
-    char* v = (char*)value_alloc(s, vlen, &new_class);
-    if (!v) return HINOTETSU_ERR_NOMEM;
-    memcpy(v, value, vlen);
-
-    value_free(s, existing->value, existing->vclass);
-
-    existing->value = v;
-    existing->vlen = (uint32_t)vlen;
-    existing->vclass = new_class;
-    existing->deleted = 0;
-    existing->expire = (ttl_seconds == 0) ? 0 : (now_sec() + ttl_seconds);
-    return HINOTETSU_OK;
+    if (entry) table_prefetch_entry(s->new_tab, h);
+    else table_prefetch_slots(s->new_tab, h);
   }
+  if (entry) table_prefetch_entry(s->tab, h);
+  else table_prefetch_slots(s->tab, h);
+}
 
-  // Create new entry
-  Entry* e = entry_create_in_pool(s, key, klen, value, vlen, ttl_seconds);
-  if (!e) return HINOTETSU_ERR_NOMEM;
+// Prefetch ahead of position j of a shard's run [.., end)
+static inline void batch_prefetch(const Shard* s, const BatchPlan* p, uint32_t j, uint32_t end) {
+  if (j + 2u < end) shard_prefetch(s, p->hash[p->order[j + 2u]], 0);
+  if (j + 1u < end) shard_prefetch(s, p->hash[p->order[j + 1u]], 1);
+}
 
-  // Insert into target table
-  int found = 0;
-  uint32_t idx = find_insert_slot(target_tab, target_cap, key, klen, h, &found);
+static inline void batch_prefetch_begin(const Shard* s, const BatchPlan* p, uint32_t begin, uint32_t end) {
+  if (begin < end) shard_prefetch(s, p->hash[p->order[begin]], 0);
+  if (begin + 1u < end) shard_prefetch(s, p->hash[p->order[begin + 1u]], 0);
+}
 
-  if (target_tab[idx] == NULL) {
-    target_tab[idx] = e;
-    (*target_used)++;
-  } else if (target_tab[idx] == TOMBSTONE_PTR) {
-    target_tab[idx] = e;
-  } else {
-    return HINOTETSU_ERR_IO;
+static size_t batch_fail(int* results, size_t n, int err) {
+  if (results) {
+    for (size_t i = 0; i < n; i++) results[i] = err;
   }
-  s->count++;
-  return HINOTETSU_OK;
+  return 0;
 }
 
-static int get_into_internal(Shard* s, uint64_t h,
-                             const char* key, size_t klen,
-                             char* dst, size_t dst_cap,
-                             size_t* out_vlen) {
-  // Do migration work (amortized)
-  if (s->new_tab) shard_migrate_batch(s);
-
-  // Search new table first
-  Entry* e = NULL;
-  uint32_t now = now_sec();
-
-  if (s->new_tab) {
-    uint32_t cap = s->new_cap;
-    uint32_t idx = idx_for(h, cap);
-    for (uint32_t i = 0; i < cap; i++) {
-      Entry* cur = s->new_tab[idx];
-      if (cur == NULL) break;
-      if (cur != TOMBSTONE_PTR && key_eq(cur, key, klen)) {
-        if (!cur->deleted && !is_expired(cur, now)) {
-          e = cur;
-        }
-        break;
-      }
-      idx = (idx + 1u) & (cap - 1u);
+static size_t batch_get(Hinotetsu* db, const char* const* keys, const size_t* klens,
+                        size_t n, HinotetsuRef* refs, int* results, int lock) {
+  for (size_t i = 0; i < n; i++) {
+    refs[i].value = NULL;
+    refs[i].vlen = 0;
+    refs[i].handle = NULL;
+  }
+  BatchPlan p;
+  if (!batch_plan_init(&p, n)) return batch_fail(results, n, HINOTETSU_ERR_NOMEM);
+  batch_plan_keys(&p, keys, klens, n, results);
+  batch_plan_group(&p, n);
+
+  size_t hits = 0;
+  for (uint32_t sh = 0; sh < HINOTETSU_SHARDS; sh++) {
+    uint32_t begin = p.start[sh], end = p.start[sh + 1u];
+    if (begin == end) continue;
+    Shard* s = &db->shards[sh];
+    if (lock) SHARD_READ_LOCK(s);
+    batch_prefetch_begin(s, &p, begin, end);
+    for (uint32_t j = begin; j < end; j++) {
+      batch_prefetch(s, &p, j, end);
+      uint32_t i = p.order[j];
+      int ret = get_ref_internal(s, p.hash[i], keys[i], klens[i], &refs[i]);
+      if (ret == HINOTETSU_OK) hits++;
+      if (results) results[i] = ret;
     }
+    if (lock) pthread_rwlock_unlock(&s->lock);
   }
+  batch_plan_free(&p);
+  return hits;
+}
 
-  // Search old table if not found
-  if (!e) {
-    uint32_t cap = s->cap;
-    uint32_t idx = idx_for(h, cap);
-    for (;;) {
-      Entry* cur = s->tab[idx];
-      if (cur == NULL) break;
-      if (cur != TOMBSTONE_PTR && key_eq(cur, key, klen)) {
-        if (!cur->deleted && !is_expired(cur, now)) {
-          e = cur;
-        }
-        break;
-      }
-      idx = (idx + 1u) & (cap - 1u);
+static void batch_release(Hinotetsu* db, HinotetsuRef* refs, size_t n, int lock) {
+  BatchPlan p;
+  if (!batch_plan_init(&p, n)) {
+    // No room to group them: release one at a time
+    for (size_t i = 0; i < n; i++) {
+      if (lock) hinotetsu_ref_release(db, &refs[i]);
+      else hinotetsu_ref_release_nolock(db, &refs[i]);
     }
+    return;
   }
-
-  if (!e) {
-    s->misses++;
-    return HINOTETSU_ERR_NOTFOUND;
+  for (size_t i = 0; i < n; i++) {
+    const Entry* e = (const Entry*)refs[i].handle;
+    if (e) {
+      p.shard[i] = shard_id_for(e->hash);
+      continue;
+    }
+    free((void*)refs[i].value);  // a private copy, or an empty ref
+    refs[i].value = NULL;
+    refs[i].vlen = 0;
+    p.shard[i] = BATCH_SKIP;
   }
+  batch_plan_group(&p, n);
+
+  for (uint32_t sh = 0; sh < HINOTETSU_SHARDS; sh++) {
+    uint32_t begin = p.start[sh], end = p.start[sh + 1u];
+    if (begin == end) continue;
+    Shard* s = &db->shards[sh];
+    int reap = 0;
+    if (lock) pthread_rwlock_rdlock(&s->lock);
+    for (uint32_t j = begin; j < end; j++) {
+      HinotetsuRef* ref = &refs[p.order[j]];
+      reap |= entry_unpin(s, (Entry*)ref->handle);
+      ref->value = NULL;
+      ref->vlen = 0;
+      ref->handle = NULL;
+    }
+    if (lock) pthread_rwlock_unlock(&s->lock);
+    if (!reap) continue;
+    if (lock) shard_write_lock(s);
+    shard_reap(s);
+    if (lock) shard_write_unlock(s);
+  }
+  batch_plan_free(&p);
+}
 
-  s->hits++;
-  *out_vlen = e->vlen;
-  if (e->vlen > dst_cap) return HINOTETSU_ERR_TOOSMALL;
-
-  memcpy(dst, e->value, e->vlen);
-  return HINOTETSU_OK;
+static size_t batch_set(Hinotetsu* db, const char* const* keys, const size_t* klens,
+                        const char* const* values, const size_t* vlens, size_t n,
+                        uint32_t ttl_seconds, int* results, int lock) {
+  BatchPlan p;
+  if (!batch_plan_init(&p, n)) return batch_fail(results, n, HINOTETSU_ERR_NOMEM);
+  batch_plan_keys(&p, keys, klens, n, results);
+  batch_plan_group(&p, n);
+
+  size_t stored = 0;
+  uint64_t ttl_ms = (uint64_t)ttl_seconds * 1000u;
+  for (uint32_t sh = 0; sh < HINOTETSU_SHARDS; sh++) {
+    uint32_t begin = p.start[sh], end = p.start[sh + 1u];
+    if (begin == end) continue;
+    Shard* s = &db->shards[sh];
+    if (lock) shard_write_lock(s);
+    batch_prefetch_begin(s, &p, begin, end);
+    for (uint32_t j = begin; j < end; j++) {
+      batch_prefetch(s, &p, j, end);
+      uint32_t i = p.order[j];
+      int ret = set_internal(s, p.hash[i], keys[i], klens[i], values[i], vlens[i], ttl_ms);
+      if (ret == HINOTETSU_OK) stored++;
+      if (results) results[i] = ret;
+    }
+    if (lock) shard_write_unlock(s);
+  }
+  batch_plan_free(&p);
+  return stored;
 }
 
-static int delete_internal(Shard* s, uint64_t h, const char* key, size_t klen) {
-  if (s->new_tab) shard_migrate_batch(s);
+static size_t batch_delete(Hinotetsu* db, const char* const* keys, const size_t* klens,
+                           size_t n, int* results, int lock) {
+  BatchPlan p;
+  if (!batch_plan_init(&p, n)) return batch_fail(results, n, HINOTETSU_ERR_NOMEM);
+  batch_plan_keys(&p, keys, klens, n, results);
+  batch_plan_group(&p, n);
+
+  size_t deleted = 0;
+  for (uint32_t sh = 0; sh < HINOTETSU_SHARDS; sh++) {
+    uint32_t begin = p.start[sh], end = p.start[sh + 1u];
+    if (begin == end) continue;
+    Shard* s = &db->shards[sh];
+    if (lock) shard_write_lock(s);
+    batch_prefetch_begin(s, &p, begin, end);
+    for (uint32_t j = begin; j < end; j++) {
+      batch_prefetch(s, &p, j, end);
+      uint32_t i = p.order[j];
+      int ret = delete_internal(s, p.hash[i], keys[i], klens[i]);
+      if (ret == HINOTETSU_OK) deleted++;
+      if (results) results[i] = ret;
+    }
+    if (lock) shard_write_unlock(s);
+  }
+  batch_plan_free(&p);
+  return deleted;
+}
 
-  uint32_t now = now_sec();
-  Entry* e = NULL;
-  Entry** tab = NULL;
-  uint32_t idx = 0;
+static void read_stats_sum(const Hinotetsu* db, HinotetsuStats* out) {
+  for (uint32_t i = 0; i < READER_SLOTS; i++) {
+    out->hits += __atomic_load_n(&db->readers.slot[i].hits, __ATOMIC_RELAXED);
+    out->misses += __atomic_load_n(&db->readers.slot[i].misses, __ATOMIC_RELAXED);
+  }
+}
 
-  // Search new table
-  if (s->new_tab) {
-    uint32_t cap = s->new_cap;
-    idx = idx_for(h, cap);
-    for (uint32_t i = 0; i < cap; i++) {
-      Entry* cur = s->new_tab[idx];
-      if (cur == NULL) break;
-      if (cur != TOMBSTONE_PTR && key_eq(cur, key, klen)) {
-        if (!cur->deleted && !is_expired(cur, now)) {
-          e = cur;
-          tab = s->new_tab;
-        }
-        break;
-      }
-      idx = (idx + 1u) & (cap - 1u);
-    }
+static void read_stats_reset(Hinotetsu* db) {
+  for (uint32_t i = 0; i < READER_SLOTS; i++) {
+    __atomic_store_n(&db->readers.slot[i].hits, 0u, __ATOMIC_RELAXED);
+    __atomic_store_n(&db->readers.slot[i].misses, 0u, __ATOMIC_RELAXED);
   }
+}
 
-  // Search old table
-  if (!e) {
-    uint32_t cap = s->cap;
-    idx = idx_for(h, cap);
-    for (;;) {
-      Entry* cur = s->tab[idx];
-      if (cur == NULL) break;
-      if (cur != TOMBSTONE_PTR && key_eq(cur, key, klen)) {
-        if (!cur->deleted && !is_expired(cur, now)) {
-          e = cur;
-          tab = s->tab;
-        }
-        break;
-      }
-      idx = (idx + 1u) & (cap - 1u);
-    }
+// Free the entries in limbo that no reader can see any more, so that the
+// stats count few dropped entries. Never waits: shards busy with a write
+// and entries readers may still hold are left for later writes.
+static void db_reclaim(Hinotetsu* db, int lock) {
+  if (!HINOTETSU_LOCKFREE_READS) return;
+  // Limbo is freed two epochs on; with no reader about, get there now
+  ebr_try_advance(&db->readers);
+  ebr_try_advance(&db->readers);
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    if (lock && !shard_write_trylock(s)) continue;
+    shard_reclaim(s, 0);
+    if (lock) shard_write_unlock(s);
   }
+}
 
-  if (!e) return HINOTETSU_ERR_NOTFOUND;
+// Rescan huge page coverage for the stats, which only read the result:
+// parsing /proc/self/smaps is too slow for every stats call
+static size_t db_huge_scan(Hinotetsu* db, int lock) {
+  HugeScan hs;
+  hs.hugetlb_bytes = 0;
+  hs.n = 0;
+  huge_scan_add(&hs, &db->arena.mem);
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    if (lock) pthread_rwlock_rdlock(&s->lock);
+    huge_scan_add(&hs, &s->tab->map);
+    if (s->new_tab) huge_scan_add(&hs, &s->new_tab->map);
+    if (lock) pthread_rwlock_unlock(&s->lock);
+  }
+  size_t bytes = huge_scan_finish(&hs);
+  __atomic_store_n(&db->huge_page_bytes, bytes, __ATOMIC_RELAXED);
+  return bytes;
+}
 
-  value_free(s, e->value, e->vclass);
-  e->deleted = 1;
-  tab[idx] = TOMBSTONE_PTR;
-  if (s->count) s->count--;
-  return HINOTETSU_OK;
+static void arena_prefault_stats(const Hinotetsu* db, HinotetsuStats* out) {
+  const Arena* a = &db->arena;
+  uint32_t done = __atomic_load_n(&a->prefault_done, __ATOMIC_ACQUIRE);
+  out->ready_us = db->ready_ns / 1000u;
+  out->prefault_us = __atomic_load_n(&a->prefault_ns, __ATOMIC_ACQUIRE) / 1000u;
+  out->prefault_bytes = (size_t)done * HINOTETSU_ARENA_CHUNK;
+  out->released_bytes = (size_t)__atomic_load_n(&a->released, __ATOMIC_RELAXED);
 }
 
 // ==================== PUBLIC API ====================
 
+void hinotetsu_options_init(HinotetsuOptions* opt) {
+  if (!opt) return;
+  memset(opt, 0, sizeof(*opt));
+  opt->pool_size = 64ULL * 1024ULL * 1024ULL;
+  opt->prefault_threads = 1;
+}
+
 Hinotetsu* hinotetsu_open(size_t pool_size_bytes) {
+  HinotetsuOptions opt;
+  hinotetsu_options_init(&opt);
+  opt.pool_size = pool_size_bytes;
+  return hinotetsu_open_ex(&opt);
+}
+
+Hinotetsu* hinotetsu_open_ex(const HinotetsuOptions* opt) {
+  if (!opt) return NULL;
+  uint64_t start_ns = mono_ns();
+  size_t pool_size_bytes = opt->pool_size;
   if (pool_size_bytes == 0) pool_size_bytes = 64ULL * 1024ULL * 1024ULL;
 
   if ((HINOTETSU_SHARDS & (HINOTETSU_SHARDS - 1u)) != 0u) return NULL;
   if ((HINOTETSU_INIT_CAP & (HINOTETSU_INIT_CAP - 1u)) != 0u) return NULL;
+  if (HINOTETSU_INIT_CAP < GROUP_WIDTH) return NULL;
+  if (HINOTETSU_ARENA_CHUNK % SLAB_PAGE_BYTES != 0u) return NULL;
+  if (HINOTETSU_ARENA_CHUNK / SLAB_PAGE_BYTES > UINT16_MAX) return NULL;
 
-  Hinotetsu* db = (Hinotetsu*)calloc(1, sizeof(Hinotetsu));
+  // Cache-line aligned for the shards
+  Hinotetsu* db = (Hinotetsu*)aligned_alloc(64, sizeof(Hinotetsu));
   if (!db) return NULL;
+  memset(db, 0, sizeof(Hinotetsu));
+
+  db->readers.slot = (ReaderSlot*)aligned_alloc(sizeof(ReaderSlot), READER_SLOTS * sizeof(ReaderSlot));
+  if (!db->readers.slot) { free(db); return NULL; }
+  memset(db->readers.slot, 0, READER_SLOTS * sizeof(ReaderSlot));
+  if (opt->combining) {
+    size_t fc_bytes = (size_t)HINOTETSU_SHARDS * READER_SLOTS * sizeof(FcSlot);
+    db->fc = (FcSlot*)aligned_alloc(sizeof(FcSlot), fc_bytes);
+    if (!db->fc) { free(db->readers.slot); free(db); return NULL; }
+    memset(db->fc, 0, fc_bytes);
+  }
 
-  db->pool_size_total = pool_size_bytes;
+  db->huge_pages = opt->huge_pages != 0;
+  slab_classes_init(&db->classes, HINOTETSU_SLAB_GROWTH_FACTOR);
+  pthread_mutex_init(&db->maint_mu, NULL);
+  pthread_cond_init(&db->maint_cv, NULL);
+
+  // At least a chunk per shard
+  size_t min_bytes = (size_t)HINOTETSU_SHARDS * HINOTETSU_ARENA_CHUNK;
+  if (pool_size_bytes < min_bytes) pool_size_bytes = min_bytes;
+  if (!arena_init(&db->arena, pool_size_bytes, db->huge_pages, opt->elastic != 0)) {
+    hinotetsu_close(db);
+    return NULL;
+  }
+  db->pool_size_total = db->arena.bytes;
 
-  size_t per = pool_size_bytes / (size_t)HINOTETSU_SHARDS;
-  if (per < (1u << 20)) per = (1u << 20);
+  uint32_t threads = opt->prefault_threads;
+  if (threads == 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (uint32_t)cpus : 1u;
+  }
+  if (!db->arena.elastic) arena_prefault(&db->arena, threads, opt->prefault_async);
 
   for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
     Shard* s = &db->shards[i];
     pthread_rwlock_init(&s->lock, NULL);
-
-    s->pool_size = per;
-    s->pool_pos = 0;
-    s->pool = (uint8_t*)malloc(s->pool_size);
-    if (!s->pool) { hinotetsu_close(db); return NULL; }
-
-    // Pre-touch memory to avoid page faults
-    for (size_t j = 0; j < s->pool_size; j += 4096) {
-      ((volatile uint8_t*)s->pool)[j] = 0;
-    }
-
-    s->cap = HINOTETSU_INIT_CAP;
-    s->tab = (Entry**)calloc((size_t)s->cap, sizeof(Entry*));
+    s->clock = &db->clock;
+    s->readers = &db->readers;
+    s->fc = db->fc ? db->fc + (size_t)i * READER_SLOTS : NULL;
+    s->classes = &db->classes;
+    s->arena = &db->arena;
+    s->id = (uint16_t)i;
+    s->chunk_head = ARENA_NONE;
+    s->spare_chunk = ARENA_NONE;
+    s->huge_tables = db->huge_pages;
+
+    s->tab = table_create(HINOTETSU_INIT_CAP, s->huge_tables);
     if (!s->tab) { hinotetsu_close(db); return NULL; }
 
-    // Pre-touch hash table
-    for (size_t j = 0; j < s->cap; j += 512) {
-      ((volatile Entry**)s->tab)[j] = NULL;
-    }
-
-    s->used = 0;
     s->count = 0;
-    s->hits = 0;
-    s->misses = 0;
+    s->item_bytes = 0;
+    s->evictions = 0;
+    s->reclaimed = 0;
+
+    memset(s->queue, 0, sizeof(s->queue));
+    wheel_reset(&s->wheel, (uint32_t)(shard_now(s) / 1000u));
 
     s->new_tab = NULL;
-    s->new_cap = 0;
-    s->new_used = 0;
     s->migrate_pos = 0;
 
-    memset(s->freelist, 0, sizeof(s->freelist));
-
     // Pre-warm slab allocator
-    slab_prewarm(s);
+    slab_reset(s);
   }
 
+  db_huge_scan(db, 0);
+  db->ready_ns = mono_ns() - start_ns;
   return db;
 }
 
 void hinotetsu_close(Hinotetsu* db) {
   if (!db) return;
+  hinotetsu_maintenance_stop(db);
   for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
     Shard* s = &db->shards[i];
-    free_table(s->tab, s->cap);
-    free_table(s->new_tab, s->new_cap);
-    if (s->pool) free(s->pool);
+    table_destroy(s->tab);
+    table_destroy(s->new_tab);
     pthread_rwlock_destroy(&s->lock);
   }
+  arena_destroy(&db->arena);
+  pthread_cond_destroy(&db->maint_cv);
+  pthread_mutex_destroy(&db->maint_mu);
+  free(db->readers.slot);
+  free(db->fc);
   free(db);
 }
 
@@ -660,13 +3554,22 @@ int hinotetsu_set(Hinotetsu* db,
                   uint32_t ttl_seconds) {
   if (!db || !key || klen == 0) return HINOTETSU_ERR_IO;
 
-  uint64_t h = fnv1a64(key, klen);
-  Shard* s = &db->shards[shard_id_for(h)];
+  uint64_t h = key_hash(key, klen);
+  FcSlot op = { .op = FC_SET, .hash = h, .key = key, .klen = klen,
+                .value = value, .vlen = vlen, .ttl_ms = (uint64_t)ttl_seconds * 1000u };
+  return shard_write(&db->shards[shard_id_for(h)], &op);
+}
 
-  pthread_rwlock_wrlock(&s->lock);
-  int ret = set_internal(s, h, key, klen, value, vlen, ttl_seconds);
-  pthread_rwlock_unlock(&s->lock);
-  return ret;
+int hinotetsu_set_ms(Hinotetsu* db,
+                     const char* key, size_t klen,
+                     const char* value, size_t vlen,
+                     uint64_t ttl_ms) {
+  if (!db || !key || klen == 0) return HINOTETSU_ERR_IO;
+
+  uint64_t h = key_hash(key, klen);
+  FcSlot op = { .op = FC_SET, .hash = h, .key = key, .klen = klen,
+                .value = value, .vlen = vlen, .ttl_ms = ttl_ms };
+  return shard_write(&db->shards[shard_id_for(h)], &op);
 }
 
 int hinotetsu_get(Hinotetsu* db,
@@ -674,38 +3577,48 @@ int hinotetsu_get(Hinotetsu* db,
                   char** out_value, size_t* out_vlen) {
   if (!db || !key || klen == 0 || !out_value || !out_vlen) return HINOTETSU_ERR_IO;
 
-  uint64_t h = fnv1a64(key, klen);
+  uint64_t h = key_hash(key, klen);
   Shard* s = &db->shards[shard_id_for(h)];
 
-  char tmp[8192];
-  size_t len = 0;
+  shard_read_begin(s);
+  int ret = get_alloc_internal(s, h, key, klen, out_value, out_vlen);
+  shard_read_end(s);
+  return ret;
+}
 
-  pthread_rwlock_rdlock(&s->lock);
-  int ret = get_into_internal(s, h, key, klen, tmp, sizeof(tmp), &len);
-  pthread_rwlock_unlock(&s->lock);
+int hinotetsu_get_ref(Hinotetsu* db,
+                      const char* key, size_t klen,
+                      HinotetsuRef* ref) {
+  if (!db || !key || klen == 0 || !ref) return HINOTETSU_ERR_IO;
+
+  uint64_t h = key_hash(key, klen);
+  Shard* s = &db->shards[shard_id_for(h)];
 
-  if (ret == HINOTETSU_ERR_TOOSMALL) {
-    char* buf = (char*)malloc(len);
-    if (!buf) return HINOTETSU_ERR_NOMEM;
+  SHARD_READ_LOCK(s);
+  int ret = get_ref_internal(s, h, key, klen, ref);
+  pthread_rwlock_unlock(&s->lock);
+  return ret;
+}
 
+void hinotetsu_ref_release(Hinotetsu* db, HinotetsuRef* ref) {
+  if (!db || !ref) return;
+  Entry* e = (Entry*)ref->handle;
+  if (!e) {
+    free((void*)ref->value);
+  } else {
+    Shard* s = &db->shards[shard_id_for(e->hash)];
     pthread_rwlock_rdlock(&s->lock);
-    ret = get_into_internal(s, h, key, klen, buf, len, &len);
+    int last = entry_unpin(s, e);
     pthread_rwlock_unlock(&s->lock);
-
-    if (ret != HINOTETSU_OK) { free(buf); return ret; }
-    *out_value = buf;
-    *out_vlen = len;
-    return HINOTETSU_OK;
+    if (last) {
+      shard_write_lock(s);
+      shard_reap(s);
+      shard_write_unlock(s);
+    }
   }
-
-  if (ret != HINOTETSU_OK) return ret;
-
-  char* out = (char*)malloc(len);
-  if (!out) return HINOTETSU_ERR_NOMEM;
-  memcpy(out, tmp, len);
-  *out_value = out;
-  *out_vlen = len;
-  return HINOTETSU_OK;
+  ref->value = NULL;
+  ref->vlen = 0;
+  ref->handle = NULL;
 }
 
 int hinotetsu_get_into(Hinotetsu* db,
@@ -714,55 +3627,64 @@ int hinotetsu_get_into(Hinotetsu* db,
                        size_t* out_vlen) {
   if (!db || !key || klen == 0 || !dst || !out_vlen) return HINOTETSU_ERR_IO;
 
-  uint64_t h = fnv1a64(key, klen);
+  uint64_t h = key_hash(key, klen);
   Shard* s = &db->shards[shard_id_for(h)];
 
-  pthread_rwlock_rdlock(&s->lock);
+  shard_read_begin(s);
   int ret = get_into_internal(s, h, key, klen, dst, dst_cap, out_vlen);
-  pthread_rwlock_unlock(&s->lock);
+  shard_read_end(s);
   return ret;
 }
 
 int hinotetsu_delete(Hinotetsu* db, const char* key, size_t klen) {
   if (!db || !key || klen == 0) return HINOTETSU_ERR_IO;
 
-  uint64_t h = fnv1a64(key, klen);
-  Shard* s = &db->shards[shard_id_for(h)];
+  uint64_t h = key_hash(key, klen);
+  FcSlot op = { .op = FC_DELETE, .hash = h, .key = key, .klen = klen };
+  return shard_write(&db->shards[shard_id_for(h)], &op);
+}
 
-  pthread_rwlock_wrlock(&s->lock);
-  int ret = delete_internal(s, h, key, klen);
-  pthread_rwlock_unlock(&s->lock);
-  return ret;
+size_t hinotetsu_mget(Hinotetsu* db,
+                      const char* const* keys, const size_t* klens, size_t n,
+                      HinotetsuRef* refs, int* results) {
+  if (!db || !keys || !klens || !refs) return 0;
+  return batch_get(db, keys, klens, n, refs, results, 1);
+}
+
+void hinotetsu_mrelease(Hinotetsu* db, HinotetsuRef* refs, size_t n) {
+  if (!db || !refs) return;
+  batch_release(db, refs, n, 1);
+}
+
+size_t hinotetsu_mset(Hinotetsu* db,
+                      const char* const* keys, const size_t* klens,
+                      const char* const* values, const size_t* vlens, size_t n,
+                      uint32_t ttl_seconds, int* results) {
+  if (!db || !keys || !klens || !values || !vlens) return 0;
+  return batch_set(db, keys, klens, values, vlens, n, ttl_seconds, results, 1);
+}
+
+size_t hinotetsu_mdelete(Hinotetsu* db,
+                         const char* const* keys, const size_t* klens, size_t n,
+                         int* results) {
+  if (!db || !keys || !klens) return 0;
+  return batch_delete(db, keys, klens, n, results, 1);
 }
 
 void hinotetsu_flush(Hinotetsu* db) {
   if (!db) return;
   for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
     Shard* s = &db->shards[i];
-    pthread_rwlock_wrlock(&s->lock);
-
-    memset(s->tab, 0, (size_t)s->cap * sizeof(Entry*));
-    if (s->new_tab) {
-      free_table(s->new_tab, s->new_cap);
-      s->new_tab = NULL;
-    }
-    s->new_cap = 0;
-    s->new_used = 0;
-    s->migrate_pos = 0;
-    s->pool_pos = 0;
-    s->used = 0;
-    s->count = 0;
-    s->hits = 0;
-    s->misses = 0;
-    memset(s->freelist, 0, sizeof(s->freelist));
-    slab_prewarm(s);
-
-    pthread_rwlock_unlock(&s->lock);
+    shard_write_lock(s);
+    shard_flush(s);
+    shard_write_unlock(s);
   }
+  read_stats_reset(db);
 }
 
 void hinotetsu_stats(Hinotetsu* db, HinotetsuStats* out) {
   if (!db || !out) return;
+  db_reclaim(db, 1);
   memset(out, 0, sizeof(*out));
   out->pool_size = db->pool_size_total;
   out->mode = 0;
@@ -771,12 +3693,195 @@ void hinotetsu_stats(Hinotetsu* db, HinotetsuStats* out) {
     Shard* s = &db->shards[i];
     pthread_rwlock_rdlock(&s->lock);
     out->count += s->count;
-    out->memory_used += s->pool_pos;
-    out->hits += s->hits;
-    out->misses += s->misses;
+    out->memory_used += (size_t)s->chunks * HINOTETSU_ARENA_CHUNK;
+    out->item_bytes += s->item_bytes;
+    out->evictions += s->evictions;
+    out->reclaimed += s->reclaimed;
+    out->combined += s->combined;
     if (s->new_tab) out->resize_in_progress++;
     pthread_rwlock_unlock(&s->lock);
   }
+  read_stats_sum(db, out);
+  out->huge_page_bytes = __atomic_load_n(&db->huge_page_bytes, __ATOMIC_RELAXED);
+  arena_prefault_stats(db, out);
+}
+
+static void shard_table_stats(Shard* s, HinotetsuTableShardStats* st) {
+  memset(st, 0, sizeof(*st));
+  table_collect_stats(s->tab, st);
+  if (s->new_tab) {
+    table_collect_stats(s->new_tab, st);
+    st->resizing = 1;
+  }
+}
+
+void hinotetsu_table_stats(Hinotetsu* db, HinotetsuTableStats* out) {
+  if (!db || !out) return;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    pthread_rwlock_rdlock(&s->lock);
+    shard_table_stats(s, &out->shards[i]);
+    pthread_rwlock_unlock(&s->lock);
+  }
+}
+
+static void shard_slab_stats(const Shard* s, HinotetsuSlabStats* out) {
+  for (uint32_t c = 0; c < s->classes->count; c++) {
+    const SlabClassState* st = &s->slab[c];
+    HinotetsuSlabClassStats* o = &out->cls[c];
+    uint64_t used = (uint64_t)st->chunks - st->free;
+    o->total_pages += st->pages;
+    o->total_chunks += st->chunks;
+    o->used_chunks += used;
+    o->free_chunks += st->free;
+    o->requested_bytes += st->requested;
+    o->wasted_bytes += used * class_size(s, (uint8_t)c) - st->requested;
+  }
+}
+
+static void shard_large_stats(const Shard* s, HinotetsuSlabStats* out) {
+  out->large_pages += s->large_pages;
+  out->large_items += s->large_items;
+  out->large_bytes += s->large_bytes;
+  out->large_requested += s->large_requested;
+  out->large_free_bytes += (uint64_t)s->large_pages * SLAB_PAGE_BYTES - s->large_bytes;
+}
+
+static void slab_stats_begin(const Hinotetsu* db, HinotetsuSlabStats* out) {
+  memset(out, 0, sizeof(*out));
+  out->classes = db->classes.count;
+  for (uint32_t c = 0; c < db->classes.count; c++) {
+    out->cls[c].chunk_size = db->classes.size[c];
+  }
+}
+
+void hinotetsu_slab_stats(Hinotetsu* db, HinotetsuSlabStats* out) {
+  if (!db || !out) return;
+  db_reclaim(db, 1);
+  slab_stats_begin(db, out);
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    pthread_rwlock_rdlock(&s->lock);
+    shard_slab_stats(s, out);
+    shard_large_stats(s, out);
+    pthread_rwlock_unlock(&s->lock);
+  }
+}
+
+size_t hinotetsu_slab_reassign(Hinotetsu* db, int src, uint32_t dst) {
+  if (!db || dst >= db->classes.count || src >= (int)db->classes.count || src == (int)dst) return 0;
+  size_t moved = 0;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    shard_write_lock(s);
+    moved += (size_t)shard_slab_reassign(s, src, (uint8_t)dst);
+    shard_write_unlock(s);
+  }
+  return moved;
+}
+
+size_t hinotetsu_slab_automove(Hinotetsu* db) {
+  if (!db) return 0;
+  size_t moved = 0;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    shard_write_lock(s);
+    moved += (size_t)shard_slab_automove(s);
+    shard_write_unlock(s);
+  }
+  return moved;
+}
+
+size_t hinotetsu_huge_page_scan(Hinotetsu* db) {
+  return db ? db_huge_scan(db, 1) : 0;
+}
+
+size_t hinotetsu_expire(Hinotetsu* db, uint32_t max_per_shard) {
+  if (!db) return 0;
+  uint64_t now = clock_now(&db->clock);
+  size_t freed = 0;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    shard_write_lock(s);
+    shard_migrate_batch(s);
+    freed += shard_expire(s, now, max_per_shard);
+    shard_reclaim(s, 0);
+    shard_write_unlock(s);
+  }
+  return freed;
+}
+
+void hinotetsu_clock_set(Hinotetsu* db, uint64_t unix_ms) {
+  if (!db) return;
+  __atomic_store_n(&db->clock.now_ms, unix_ms, __ATOMIC_RELAXED);
+  __atomic_fetch_or(&db->clock.driven, CLOCK_DRIVEN_EXTERNAL, __ATOMIC_RELEASE);
+}
+
+// Ticks the engine clock every HINOTETSU_CLOCK_TICK_MS (unless an external
+// driver owns it) and runs an expiry and slab automove pass every
+// maint_interval_ms
+static void* maintenance_main(void* arg) {
+  Hinotetsu* db = (Hinotetsu*)arg;
+  uint64_t next_expire = wall_ms() + db->maint_interval_ms;
+  uint64_t next_huge_scan = wall_ms() + HINOTETSU_HUGE_SCAN_MS;
+
+  pthread_mutex_lock(&db->maint_mu);
+  while (!db->maint_stop) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t ns = (uint64_t)ts.tv_nsec + (uint64_t)HINOTETSU_CLOCK_TICK_MS * 1000000ULL;
+    ts.tv_sec += (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec = (long)(ns % 1000000000ULL);
+    pthread_cond_timedwait(&db->maint_cv, &db->maint_mu, &ts);
+    if (db->maint_stop) break;
+
+    uint64_t now = wall_ms();
+    if (!(__atomic_load_n(&db->clock.driven, __ATOMIC_RELAXED) & CLOCK_DRIVEN_EXTERNAL)) {
+      __atomic_store_n(&db->clock.now_ms, now, __ATOMIC_RELAXED);
+    }
+    if (now < next_expire) continue;
+    next_expire = now + db->maint_interval_ms;
+
+    pthread_mutex_unlock(&db->maint_mu);
+    hinotetsu_expire(db, HINOTETSU_EXPIRE_BATCH);
+    hinotetsu_slab_automove(db);
+    if (now >= next_huge_scan) {
+      next_huge_scan = now + HINOTETSU_HUGE_SCAN_MS;
+      hinotetsu_huge_page_scan(db);
+    }
+    pthread_mutex_lock(&db->maint_mu);
+  }
+  pthread_mutex_unlock(&db->maint_mu);
+  return NULL;
+}
+
+int hinotetsu_maintenance_start(Hinotetsu* db, uint32_t interval_ms) {
+  if (!db) return HINOTETSU_ERR_IO;
+  if (db->maint_running) return HINOTETSU_OK;
+  db->maint_interval_ms = interval_ms ? interval_ms : 1u;
+  db->maint_stop = 0;
+
+  if (!(db->clock.driven & CLOCK_DRIVEN_EXTERNAL)) {
+    __atomic_store_n(&db->clock.now_ms, wall_ms(), __ATOMIC_RELAXED);
+  }
+  __atomic_fetch_or(&db->clock.driven, CLOCK_DRIVEN_TICKER, __ATOMIC_RELEASE);
+  if (pthread_create(&db->maint_thread, NULL, maintenance_main, db) != 0) {
+    __atomic_fetch_and(&db->clock.driven, ~CLOCK_DRIVEN_TICKER, __ATOMIC_RELEASE);
+    return HINOTETSU_ERR_IO;
+  }
+  db->maint_running = 1;
+  return HINOTETSU_OK;
+}
+
+void hinotetsu_maintenance_stop(Hinotetsu* db) {
+  if (!db || !db->maint_running) return;
+  pthread_mutex_lock(&db->maint_mu);
+  db->maint_stop = 1;
+  pthread_cond_signal(&db->maint_cv);
+  pthread_mutex_unlock(&db->maint_mu);
+  pthread_join(db->maint_thread, NULL);
+  db->maint_running = 0;
+  __atomic_fetch_and(&db->clock.driven, ~CLOCK_DRIVEN_TICKER, __ATOMIC_RELEASE);
 }
 
 const char* hinotetsu_version(void) {
@@ -790,9 +3895,19 @@ int hinotetsu_set_nolock(Hinotetsu* db,
                          const char* value, size_t vlen,
                          uint32_t ttl_seconds) {
   if (!db || !key || klen == 0) return HINOTETSU_ERR_IO;
-  uint64_t h = fnv1a64(key, klen);
+  uint64_t h = key_hash(key, klen);
+  Shard* s = &db->shards[shard_id_for(h)];
+  return set_internal(s, h, key, klen, value, vlen, (uint64_t)ttl_seconds * 1000u);
+}
+
+int hinotetsu_set_ms_nolock(Hinotetsu* db,
+                            const char* key, size_t klen,
+                            const char* value, size_t vlen,
+                            uint64_t ttl_ms) {
+  if (!db || !key || klen == 0) return HINOTETSU_ERR_IO;
+  uint64_t h = key_hash(key, klen);
   Shard* s = &db->shards[shard_id_for(h)];
-  return set_internal(s, h, key, klen, value, vlen, ttl_seconds);
+  return set_internal(s, h, key, klen, value, vlen, ttl_ms);
 }
 
 int hinotetsu_get_into_nolock(Hinotetsu* db,
@@ -800,39 +3915,79 @@ int hinotetsu_get_into_nolock(Hinotetsu* db,
                               char* dst, size_t dst_cap,
                               size_t* out_vlen) {
   if (!db || !key || klen == 0 || !dst || !out_vlen) return HINOTETSU_ERR_IO;
-  uint64_t h = fnv1a64(key, klen);
+  uint64_t h = key_hash(key, klen);
   Shard* s = &db->shards[shard_id_for(h)];
   return get_into_internal(s, h, key, klen, dst, dst_cap, out_vlen);
 }
 
+int hinotetsu_get_ref_nolock(Hinotetsu* db,
+                             const char* key, size_t klen,
+                             HinotetsuRef* ref) {
+  if (!db || !key || klen == 0 || !ref) return HINOTETSU_ERR_IO;
+  uint64_t h = key_hash(key, klen);
+  Shard* s = &db->shards[shard_id_for(h)];
+  return get_ref_internal(s, h, key, klen, ref);
+}
+
+void hinotetsu_ref_release_nolock(Hinotetsu* db, HinotetsuRef* ref) {
+  if (!db || !ref) return;
+  Entry* e = (Entry*)ref->handle;
+  if (!e) {
+    free((void*)ref->value);
+  } else {
+    Shard* s = &db->shards[shard_id_for(e->hash)];
+    if (entry_unpin(s, e)) shard_reap(s);
+  }
+  ref->value = NULL;
+  ref->vlen = 0;
+  ref->handle = NULL;
+}
+
 int hinotetsu_delete_nolock(Hinotetsu* db, const char* key, size_t klen) {
   if (!db || !key || klen == 0) return HINOTETSU_ERR_IO;
-  uint64_t h = fnv1a64(key, klen);
+  uint64_t h = key_hash(key, klen);
   Shard* s = &db->shards[shard_id_for(h)];
   return delete_internal(s, h, key, klen);
 }
 
+size_t hinotetsu_mget_nolock(Hinotetsu* db,
+                             const char* const* keys, const size_t* klens, size_t n,
+                             HinotetsuRef* refs, int* results) {
+  if (!db || !keys || !klens || !refs) return 0;
+  return batch_get(db, keys, klens, n, refs, results, 0);
+}
+
+void hinotetsu_mrelease_nolock(Hinotetsu* db, HinotetsuRef* refs, size_t n) {
+  if (!db || !refs) return;
+  batch_release(db, refs, n, 0);
+}
+
+size_t hinotetsu_mset_nolock(Hinotetsu* db,
+                             const char* const* keys, const size_t* klens,
+                             const char* const* values, const size_t* vlens, size_t n,
+                             uint32_t ttl_seconds, int* results) {
+  if (!db || !keys || !klens || !values || !vlens) return 0;
+  return batch_set(db, keys, klens, values, vlens, n, ttl_seconds, results, 0);
+}
+
+size_t hinotetsu_mdelete_nolock(Hinotetsu* db,
+                                const char* const* keys, const size_t* klens, size_t n,
+                                int* results) {
+  if (!db || !keys || !klens) return 0;
+  return batch_delete(db, keys, klens, n, results, 0);
+}
+
 void hinotetsu_flush_nolock(Hinotetsu* db) {
   if (!db) return;
   for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
-    Shard* s = &db->shards[i];
-    memset(s->tab, 0, (size_t)s->cap * sizeof(Entry*));
-    if (s->new_tab) { free_table(s->new_tab, s->new_cap); s->new_tab = NULL; }
-    s->new_cap = 0;
-    s->new_used = 0;
-    s->migrate_pos = 0;
-    s->pool_pos = 0;
-    s->used = 0;
-    s->count = 0;
-    s->hits = 0;
-    s->misses = 0;
-    memset(s->freelist, 0, sizeof(s->freelist));
-    slab_prewarm(s);
+    shard_flush(&db->shards[i]);
   }
+  read_stats_reset(db);
 }
 
 void hinotetsu_stats_nolock(Hinotetsu* db, HinotetsuStats* out) {
   if (!db || !out) return;
+  db_reclaim(db, 0);
   memset(out, 0, sizeof(*out));
   out->pool_size = db->pool_size_total;
   out->mode = 0;
@@ -840,12 +3995,69 @@ void hinotetsu_stats_nolock(Hinotetsu* db, HinotetsuStats* out) {
   for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
     Shard* s = &db->shards[i];
     out->count += s->count;
-    out->memory_used += s->pool_pos;
-    out->hits += s->hits;
-    out->misses += s->misses;
+    out->memory_used += (size_t)s->chunks * HINOTETSU_ARENA_CHUNK;
+    out->item_bytes += s->item_bytes;
+    out->evictions += s->evictions;
+    out->reclaimed += s->reclaimed;
+    out->combined += s->combined;
     if (s->new_tab) out->resize_in_progress++;
   }
+  read_stats_sum(db, out);
+  out->huge_page_bytes = __atomic_load_n(&db->huge_page_bytes, __ATOMIC_RELAXED);
+  arena_prefault_stats(db, out);
+}
+
+size_t hinotetsu_huge_page_scan_nolock(Hinotetsu* db) {
+  return db ? db_huge_scan(db, 0) : 0;
+}
+
+size_t hinotetsu_expire_nolock(Hinotetsu* db, uint32_t max_per_shard) {
+  if (!db) return 0;
+  uint64_t now = clock_now(&db->clock);
+  size_t freed = 0;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    Shard* s = &db->shards[i];
+    shard_migrate_batch(s);
+    freed += shard_expire(s, now, max_per_shard);
+    shard_reclaim(s, 0);
+  }
+  return freed;
+}
+
+void hinotetsu_table_stats_nolock(Hinotetsu* db, HinotetsuTableStats* out) {
+  if (!db || !out) return;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    shard_table_stats(&db->shards[i], &out->shards[i]);
+  }
+}
+
+void hinotetsu_slab_stats_nolock(Hinotetsu* db, HinotetsuSlabStats* out) {
+  if (!db || !out) return;
+  db_reclaim(db, 0);
+  slab_stats_begin(db, out);
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    shard_slab_stats(&db->shards[i], out);
+    shard_large_stats(&db->shards[i], out);
+  }
+}
+
+size_t hinotetsu_slab_reassign_nolock(Hinotetsu* db, int src, uint32_t dst) {
+  if (!db || dst >= db->classes.count || src >= (int)db->classes.count || src == (int)dst) return 0;
+  size_t moved = 0;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    moved += (size_t)shard_slab_reassign(&db->shards[i], src, (uint8_t)dst);
+  }
+  return moved;
+}
+
+size_t hinotetsu_slab_automove_nolock(Hinotetsu* db) {
+  if (!db) return 0;
+  size_t moved = 0;
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    moved += (size_t)shard_slab_automove(&db->shards[i]);
+  }
+  return moved;
 }
 
 void hinotetsu_lock(Hinotetsu* db) { (void)db; }
-void hinotetsu_unlock(Hinotetsu* db) { (void)db; }
\ No newline at end of file
+void hinotetsu_unlock(Hinotetsu* db) { (void)db; }
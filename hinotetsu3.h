@@ -1,8 +1,14 @@
 // hinotetsu3.h
 // Ultra-low-latency sharded KV store with incremental resize
 // - Incremental hash table resize (no spike on grow)
-// - Pre-warmed slab allocator
-// - Memory pre-touch on startup
+// - Pre-warmed slab allocator with page rebalancing between classes
+// - One pre-touched memory arena, leased to shards in chunks on demand,
+//   optionally on 2MB huge pages with the hash tables, or an elastic one
+//   that faults in on use and returns idle chunks to the OS
+// - Per-shard eviction (SIEVE/CLOCK/LRU) once the arena is spent
+// - Optional lock-free reads with epoch-based reclamation
+// - Optional flat combining of writes to contended shards
+// - Active TTL expiry (per-shard timing wheel)
 // License: BUSL (Business Source License)
 #pragma once
 
@@ -43,34 +49,206 @@ extern "C" {
 #define HINOTETSU_SLAB_PAGE_SIZE (64u * 1024u)
 #endif
 
+// Arena chunk leased to a shard at a time; a multiple of the slab page size
+#ifndef HINOTETSU_ARENA_CHUNK
+#define HINOTETSU_ARENA_CHUNK (1024u * 1024u)
+#endif
+
+// Chunk size ratio between neighbouring slab classes (memcached's -f)
+#ifndef HINOTETSU_SLAB_GROWTH_FACTOR
+#define HINOTETSU_SLAB_GROWTH_FACTOR 1.25
+#endif
+
+// Upper bound on slab classes; the largest is always 1 << HINOTETSU_SLAB_MAX_SHIFT
+#ifndef HINOTETSU_SLAB_MAX_CLASSES
+#define HINOTETSU_SLAB_MAX_CLASSES 64u
+#endif
+
+// Upper bound on HinotetsuOptions.prefault_threads
+#ifndef HINOTETSU_PREFAULT_MAX_THREADS
+#define HINOTETSU_PREFAULT_MAX_THREADS 64u
+#endif
+
+// Slab automove prefers pages with at most this share of chunks in use
+#ifndef HINOTETSU_SLAB_AUTOMOVE_USED_PCT
+#define HINOTETSU_SLAB_AUTOMOVE_USED_PCT 25u
+#endif
+
 // Incremental resize: entries to migrate per operation
 #ifndef HINOTETSU_MIGRATE_BATCH
 #define HINOTETSU_MIGRATE_BATCH 16u
 #endif
 
+// Shard hash table layout
+#define HINOTETSU_TABLE_LINEAR    0  // Entry* slots, linear probing, load 7/10
+#define HINOTETSU_TABLE_SWISS     1  // SIMD-scanned 7-bit tags, load 7/8
+#define HINOTETSU_TABLE_ROBINHOOD 2  // backward-shift delete, no tombstones, load 9/10
+#define HINOTETSU_TABLE_CUCKOO    3  // 4-slot buckets, two per key, 8-bit tags, load 19/20
+
+#ifndef HINOTETSU_TABLE
+#define HINOTETSU_TABLE HINOTETSU_TABLE_LINEAR
+#endif
+
+// Key hash. Each one mixes every key byte into its top bits, which pick
+// the shard and the table tag.
+#define HINOTETSU_HASH_FNV1A  0
+#define HINOTETSU_HASH_WYHASH 1
+#define HINOTETSU_HASH_CRC32C 2  // needs SSE4.2 or ARMv8 CRC
+
+#ifndef HINOTETSU_HASH
+#define HINOTETSU_HASH HINOTETSU_HASH_WYHASH
+#endif
+
+// Eviction policy used when a shard's memory is exhausted
+#define HINOTETSU_EVICT_NONE  0  // fail with HINOTETSU_ERR_NOMEM
+#define HINOTETSU_EVICT_CLOCK 1
+#define HINOTETSU_EVICT_SIEVE 2
+#define HINOTETSU_EVICT_LRU   3  // readers take the write lock to reorder
+
+#ifndef HINOTETSU_EVICTION
+#define HINOTETSU_EVICTION HINOTETSU_EVICT_SIEVE
+#endif
+
+// Copying reads without locks: hinotetsu_get and hinotetsu_get_into take
+// no shard lock and write nothing but the entry's eviction bit. The reads
+// that pin entries (hinotetsu_get_ref, hinotetsu_mget) still take the read
+// lock. Tables and entries are published with release stores; entries,
+// values and tables a writer drops are freed only once no reader can still
+// see them (epoch-based reclamation), which makes writers wait for readers
+// now and then. Not with HINOTETSU_EVICT_LRU.
+#ifndef HINOTETSU_LOCKFREE_READS
+#define HINOTETSU_LOCKFREE_READS 0
+#endif
+
+// Max victims evicted to satisfy a single allocation
+#ifndef HINOTETSU_EVICT_TRIES
+#define HINOTETSU_EVICT_TRIES 64u
+#endif
+
+// Expired entries freed per write by the shard's timing wheel
+#ifndef HINOTETSU_RECLAIM_BATCH
+#define HINOTETSU_RECLAIM_BATCH 4u
+#endif
+
+// Expired entries freed per shard by each maintenance pass
+#ifndef HINOTETSU_EXPIRE_BATCH
+#define HINOTETSU_EXPIRE_BATCH 256u
+#endif
+
+// Huge page coverage refresh period of the maintenance thread
+#ifndef HINOTETSU_HUGE_SCAN_MS
+#define HINOTETSU_HUGE_SCAN_MS 10000u
+#endif
+
+// Engine clock update period of the maintenance thread
+#ifndef HINOTETSU_CLOCK_TICK_MS
+#define HINOTETSU_CLOCK_TICK_MS 1u
+#endif
+
 typedef struct Hinotetsu Hinotetsu;
 
 typedef struct HinotetsuStats {
   size_t count;
-  size_t memory_used;
+  size_t memory_used;         // arena bytes leased to shards
+  size_t item_bytes;          // slab bytes held by stored entries
   size_t pool_size;
   size_t hits;
   size_t misses;
+  size_t evictions;           // live entries evicted to make room
+  size_t reclaimed;           // expired entries whose memory was recycled
+  size_t combined;            // writes run by another writer (combining)
   size_t resize_in_progress;  // number of shards currently resizing
+  size_t huge_page_bytes;     // arena and table memory on 2MB pages, as of
+                              // the last hinotetsu_huge_page_scan()
+  uint64_t ready_us;          // time hinotetsu_open_ex() took
+  uint64_t prefault_us;       // time to fault in the arena, 0 until done
+  size_t prefault_bytes;      // arena bytes faulted in so far
+  size_t released_bytes;      // arena bytes returned to the OS (elastic)
   size_t bloom_bits;
   double bloom_fill_rate;
   int mode;
 } HinotetsuStats;
 
+// Shard hash table diagnostics. Displacement is the distance from an entry's
+// home position to its slot: slots for HINOTETSU_TABLE_LINEAR, probe groups
+// for HINOTETSU_TABLE_SWISS. For HINOTETSU_TABLE_CUCKOO it is 0 in the first
+// bucket, 1 in the other and 2 in the stash. While a shard resizes both
+// tables are counted.
+#define HINOTETSU_PROBE_HIST 16u  // last bucket collects longer displacements
+
+typedef struct HinotetsuTableShardStats {
+  uint32_t capacity;
+  uint32_t live;
+  uint32_t tombstones;
+  uint32_t home_slots;        // distinct home positions of live entries
+  uint32_t max_displacement;
+  uint32_t resizing;
+  uint64_t probe_hist[HINOTETSU_PROBE_HIST];  // live entries by displacement
+} HinotetsuTableShardStats;
+
+typedef struct HinotetsuTableStats {
+  HinotetsuTableShardStats shards[HINOTETSU_SHARDS];
+} HinotetsuTableStats;
+
+// Slab class usage summed over all shards. Values larger than the biggest
+// class take extents from spans of slab pages, reported as large_*.
+typedef struct HinotetsuSlabClassStats {
+  uint32_t chunk_size;
+  uint32_t total_pages;
+  uint64_t total_chunks;
+  uint64_t used_chunks;
+  uint64_t free_chunks;
+  uint64_t requested_bytes;   // bytes asked for by the used chunks
+  uint64_t wasted_bytes;      // used_chunks * chunk_size - requested_bytes
+} HinotetsuSlabClassStats;
+
+typedef struct HinotetsuSlabStats {
+  uint32_t classes;
+  HinotetsuSlabClassStats cls[HINOTETSU_SLAB_MAX_CLASSES];
+  uint32_t large_pages;       // slab pages held by large-object spans
+  uint64_t large_items;
+  uint64_t large_bytes;       // extent bytes in use, headers included
+  uint64_t large_requested;
+  uint64_t large_free_bytes;  // span bytes not in use
+} HinotetsuSlabStats;
+
+// Open options; start from hinotetsu_options_init()
+typedef struct HinotetsuOptions {
+  size_t pool_size;  // arena bytes (0 = 64MB)
+  int huge_pages;    // back the arena and large tables with 2MB pages:
+                     // MAP_HUGETLB, else madvise(MADV_HUGEPAGE); see
+                     // HinotetsuStats.huge_page_bytes for what was obtained
+  uint32_t prefault_threads;  // threads faulting in the arena at open
+                              // (default 1, 0 = one per online CPU)
+  int prefault_async;         // return before the arena is faulted in and
+                              // finish in the background
+  int elastic;                // pool_size is a ceiling: chunks fault in on
+                              // use, idle ones go back to the OS (no
+                              // pre-fault, no slab pre-warming)
+  int combining;              // flat combining: a SET or DELETE that finds
+                              // its shard locked is handed to the lock
+                              // holder, which runs such writes in a batch
+} HinotetsuOptions;
+
+void hinotetsu_options_init(HinotetsuOptions* opt);
+
 // Core API (thread-safe with locks)
 Hinotetsu* hinotetsu_open(size_t pool_size_bytes);
+Hinotetsu* hinotetsu_open_ex(const HinotetsuOptions* opt);
 void hinotetsu_close(Hinotetsu* db);
 
+// On HINOTETSU_ERR_NOMEM a key that was already stored keeps its old value
 int hinotetsu_set(Hinotetsu* db,
                   const char* key, size_t klen,
                   const char* value, size_t vlen,
                   uint32_t ttl_seconds);
 
+// Same as hinotetsu_set with a TTL in milliseconds (0 = no expiry)
+int hinotetsu_set_ms(Hinotetsu* db,
+                     const char* key, size_t klen,
+                     const char* value, size_t vlen,
+                     uint64_t ttl_ms);
+
 int hinotetsu_get(Hinotetsu* db,
                   const char* key, size_t klen,
                   char** out_value, size_t* out_vlen);
@@ -80,10 +258,85 @@ int hinotetsu_get_into(Hinotetsu* db,
                        char* dst, size_t dst_cap,
                        size_t* out_vlen);
 
+// Borrowed reads: ref->value points at the stored value, which stays
+// readable and unchanged until hinotetsu_ref_release(), even if the key is
+// overwritten, deleted, evicted or flushed meanwhile. Release every
+// reference before hinotetsu_close(); hold them briefly, since a pinned
+// entry's memory is not reused and the slab mover skips its page.
+typedef struct HinotetsuRef {
+  const char* value;
+  size_t vlen;
+  void* handle;  // internal
+} HinotetsuRef;
+
+int hinotetsu_get_ref(Hinotetsu* db,
+                      const char* key, size_t klen,
+                      HinotetsuRef* ref);
+void hinotetsu_ref_release(Hinotetsu* db, HinotetsuRef* ref);
+
 int hinotetsu_delete(Hinotetsu* db, const char* key, size_t klen);
 
+// Batches: keys are grouped by shard so each shard is locked once, and the
+// next keys' slots are prefetched while one is looked up. results (optional)
+// receives the per-key status in the order given; an empty key gets
+// HINOTETSU_ERR_IO. Each returns the number of keys that succeeded.
+// hinotetsu_mget fills refs[i] like hinotetsu_get_ref (a miss leaves it
+// empty); hand them all to hinotetsu_mrelease afterwards.
+size_t hinotetsu_mget(Hinotetsu* db,
+                      const char* const* keys, const size_t* klens, size_t n,
+                      HinotetsuRef* refs, int* results);
+void hinotetsu_mrelease(Hinotetsu* db, HinotetsuRef* refs, size_t n);
+size_t hinotetsu_mset(Hinotetsu* db,
+                      const char* const* keys, const size_t* klens,
+                      const char* const* values, const size_t* vlens, size_t n,
+                      uint32_t ttl_seconds, int* results);
+size_t hinotetsu_mdelete(Hinotetsu* db,
+                         const char* const* keys, const size_t* klens, size_t n,
+                         int* results);
+
 void hinotetsu_flush(Hinotetsu* db);
 void hinotetsu_stats(Hinotetsu* db, HinotetsuStats* out);
+void hinotetsu_table_stats(Hinotetsu* db, HinotetsuTableStats* out);
+void hinotetsu_slab_stats(Hinotetsu* db, HinotetsuSlabStats* out);
+
+// Active expiry: free entries whose TTL has passed, at most max_per_shard
+// per shard. Returns the number freed. Writes also expire a few entries each.
+// Each pass also moves a batch of entries of any table resize in progress,
+// which otherwise only writes advance.
+size_t hinotetsu_expire(Hinotetsu* db, uint32_t max_per_shard);
+
+// Slab page rebalancing. Pages are carved for one slab class but can be
+// emptied and handed to another: live entries move to free chunks of their
+// class or are evicted. Both return the number of pages moved, summed over
+// shards.
+// hinotetsu_slab_reassign moves one page per shard from class src (or, if
+// src < 0, the class with the most free chunks) to class dst. Classes are
+// 0-based indexes into HinotetsuSlabStats.cls.
+// hinotetsu_slab_automove gives the class (or the large-object allocator)
+// that most often ran dry since the last call a mostly-free page
+// (HINOTETSU_SLAB_AUTOMOVE_USED_PCT) of another, or, once no page is, the
+// emptiest page of the class holding the most. No class loses its last page.
+size_t hinotetsu_slab_reassign(Hinotetsu* db, int src, uint32_t dst);
+size_t hinotetsu_slab_automove(Hinotetsu* db);
+
+// Measure how much of the arena and the tables is backed by 2MB pages and
+// keep it for HinotetsuStats.huge_page_bytes. Transparent huge pages are
+// counted from /proc/self/smaps, which takes milliseconds: hinotetsu_open
+// scans once, after that call this now and then. Returns the bytes found.
+size_t hinotetsu_huge_page_scan(Hinotetsu* db);
+
+// Run hinotetsu_expire(db, HINOTETSU_EXPIRE_BATCH) and
+// hinotetsu_slab_automove() every interval_ms on a helper thread until
+// hinotetsu_maintenance_stop() or hinotetsu_close(). The thread also keeps
+// the engine clock current and runs hinotetsu_huge_page_scan() every
+// HINOTETSU_HUGE_SCAN_MS.
+int hinotetsu_maintenance_start(Hinotetsu* db, uint32_t interval_ms);
+void hinotetsu_maintenance_stop(Hinotetsu* db);
+
+// Engine clock. Operations read a cached Unix time in milliseconds; until
+// the clock is driven (by this call or the maintenance thread) they read the
+// system clock instead. Once called, the caller keeps driving it.
+void hinotetsu_clock_set(Hinotetsu* db, uint64_t unix_ms);
 const char* hinotetsu_version(void);
 
 // Lock-free API (single-threaded use only)
@@ -92,15 +345,41 @@ int hinotetsu_set_nolock(Hinotetsu* db,
                          const char* value, size_t vlen,
                          uint32_t ttl_seconds);
 
+int hinotetsu_set_ms_nolock(Hinotetsu* db,
+                            const char* key, size_t klen,
+                            const char* value, size_t vlen,
+                            uint64_t ttl_ms);
+
 int hinotetsu_get_into_nolock(Hinotetsu* db,
                               const char* key, size_t klen,
                               char* dst, size_t dst_cap,
                               size_t* out_vlen);
 
+int hinotetsu_get_ref_nolock(Hinotetsu* db,
+                             const char* key, size_t klen,
+                             HinotetsuRef* ref);
+void hinotetsu_ref_release_nolock(Hinotetsu* db, HinotetsuRef* ref);
 int hinotetsu_delete_nolock(Hinotetsu* db, const char* key, size_t klen);
+size_t hinotetsu_mget_nolock(Hinotetsu* db,
+                             const char* const* keys, const size_t* klens, size_t n,
+                             HinotetsuRef* refs, int* results);
+void hinotetsu_mrelease_nolock(Hinotetsu* db, HinotetsuRef* refs, size_t n);
+size_t hinotetsu_mset_nolock(Hinotetsu* db,
+                             const char* const* keys, const size_t* klens,
+                             const char* const* values, const size_t* vlens, size_t n,
+                             uint32_t ttl_seconds, int* results);
+size_t hinotetsu_mdelete_nolock(Hinotetsu* db,
+                                const char* const* keys, const size_t* klens, size_t n,
+                                int* results);
 
 void hinotetsu_flush_nolock(Hinotetsu* db);
 void hinotetsu_stats_nolock(Hinotetsu* db, HinotetsuStats* out);
+void hinotetsu_table_stats_nolock(Hinotetsu* db, HinotetsuTableStats* out);
+void hinotetsu_slab_stats_nolock(Hinotetsu* db, HinotetsuSlabStats* out);
+size_t hinotetsu_slab_reassign_nolock(Hinotetsu* db, int src, uint32_t dst);
+size_t hinotetsu_slab_automove_nolock(Hinotetsu* db);
+size_t hinotetsu_huge_page_scan_nolock(Hinotetsu* db);
+size_t hinotetsu_expire_nolock(Hinotetsu* db, uint32_t max_per_shard);
 
 // Compatibility
 void hinotetsu_lock(Hinotetsu* db);
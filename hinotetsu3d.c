@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <ctype.h>
+#include <time.h>
 
 #ifdef _WIN32
   #include <winsock2.h>
@@ -59,27 +60,46 @@
 #define FLUSH_THRESHOLD (64 * 1024)  // Flush more frequently
 #endif
 
+#ifndef BORROW_MIN_BYTES
+#define BORROW_MIN_BYTES 4096  // smaller GET values are copied into the outbuf
+#endif
+
+#ifndef EXPIRE_INTERVAL_MS
+#define EXPIRE_INTERVAL_MS 100  // Active TTL expiry tick
+#endif
+
+#ifndef SLAB_AUTOMOVE_INTERVAL_MS
+#define SLAB_AUTOMOVE_INTERVAL_MS 1000  // Slab page rebalancing pass
+#endif
+
+#ifndef HUGE_SCAN_INTERVAL_MS
+#define HUGE_SCAN_INTERVAL_MS 10000  // huge_page_bytes refresh (-L only)
+#endif
+
 // -----------------------------
 // Global DB
 // -----------------------------
 static Hinotetsu* g_db = NULL;
+static int g_slab_automove = 1;  // "slabs automove 0|1"
 
 // -----------------------------
-// Reusable GET buffer (single-threaded, so global is fine)
+// Engine clock, driven from the loop time so operations never call time()
 // -----------------------------
-static char* g_get_buf = NULL;
-static size_t g_get_buf_cap = 0;
-
-static char* ensure_get_buf(size_t need) {
-  if (g_get_buf_cap < need) {
-    size_t cap = g_get_buf_cap ? g_get_buf_cap : 4096;
-    while (cap < need) cap <<= 1;
-    char* nb = (char*)realloc(g_get_buf, cap);
-    if (!nb) return NULL;
-    g_get_buf = nb;
-    g_get_buf_cap = cap;
-  }
-  return g_get_buf;
+static uint64_t g_clock_base_ms = 0;  // Unix ms when uv_now() was 0
+
+static void clock_init(void) {
+#ifdef _WIN32
+  uint64_t wall = (uint64_t)time(NULL) * 1000u;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  uint64_t wall = (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+#endif
+  g_clock_base_ms = wall - uv_now(uv_default_loop());
+}
+
+static inline void clock_update(void) {
+  hinotetsu_clock_set(g_db, g_clock_base_ms + uv_now(uv_default_loop()));
 }
 
 // -----------------------------
@@ -204,6 +224,29 @@ static int parse_single_key_cmd(const char* line, const char* cmd_name, char* ke
 // -----------------------------
 typedef struct Conn Conn;
 
+// Output run: bytes of the outbuf, or a value borrowed from the engine
+typedef struct OutSeg {
+  const char* ext;  // borrowed value, NULL for outbuf bytes
+  size_t off;       // start in the outbuf when ext is NULL
+  size_t len;
+} OutSeg;
+
+// One side of the double-buffered output. Borrowed values are written
+// straight from engine memory; their references are released once the
+// write completes. Without any, the outbuf goes out as a single buffer.
+typedef struct OutBuf {
+  char* buf;
+  size_t len;      // bytes in buf
+  size_t cap;
+  size_t pending;  // len plus borrowed bytes
+  OutSeg* segs;    // empty unless a value is borrowed
+  size_t nsegs;
+  size_t segs_cap;
+  HinotetsuRef* refs;
+  size_t nrefs;
+  size_t refs_cap;
+} OutBuf;
+
 struct Conn {
   uv_tcp_t tcp;
 
@@ -213,10 +256,10 @@ struct Conn {
   size_t in_cap;
 
   // Double-buffered output (swap on flush)
-  char* outbuf[2];
-  size_t out_len;
-  size_t out_cap;
-  int out_active;  // which buffer is being written (0 or 1)
+  OutBuf out[2];
+  int out_active;  // which buffer output is appended to (0 or 1)
+  uv_buf_t* iov;   // scatter list of the write in flight
+  size_t iov_cap;
 
   // Pending set state
   int pending_set;
@@ -238,29 +281,85 @@ static void on_closed(uv_handle_t* handle);
 // -----------------------------
 // Output buffering (double-buffered)
 // -----------------------------
+// The side that output is appended to. conn_flush_output swaps sides
+// before writing, so the one in flight is always the other.
+static OutBuf* conn_out(Conn* c) {
+  return &c->out[c->out_active];
+}
+
+static void outbuf_push_seg(OutBuf* o, const char* ext, size_t off, size_t len) {
+  if (o->nsegs == o->segs_cap) {
+    o->segs_cap = o->segs_cap ? o->segs_cap * 2 : 16;
+    o->segs = (OutSeg*)xrealloc(o->segs, o->segs_cap * sizeof(OutSeg));
+  }
+  OutSeg* seg = &o->segs[o->nsegs++];
+  seg->ext = ext;
+  seg->off = off;
+  seg->len = len;
+}
+
+// Empty a side once written (or dropped), releasing its borrowed values
+static void outbuf_reset(OutBuf* o) {
+  for (size_t i = 0; i < o->nrefs; i++) {
+    hinotetsu_ref_release_nolock(g_db, &o->refs[i]);
+  }
+  o->nrefs = 0;
+  o->nsegs = 0;
+  o->len = 0;
+  o->pending = 0;
+}
+
+static void outbuf_free(OutBuf* o) {
+  outbuf_reset(o);
+  free(o->buf);
+  free(o->segs);
+  free(o->refs);
+}
+
 static void conn_append_output(Conn* c, const char* data, size_t len) {
   if (c->closing) return;
 
-  int idx = c->writing ? (1 - c->out_active) : c->out_active;
-  char** buf = &c->outbuf[idx];
-
-  if (c->out_len + len > c->out_cap) {
-    size_t cap = c->out_cap ? c->out_cap : WRITE_BUF_INIT_CAP;
-    while (cap < c->out_len + len) cap <<= 1;
-    // Grow both buffers to same size
-    c->outbuf[0] = (char*)xrealloc(c->outbuf[0], cap);
-    c->outbuf[1] = (char*)xrealloc(c->outbuf[1], cap);
-    c->out_cap = cap;
+  OutBuf* o = conn_out(c);
+  if (o->len + len > o->cap) {
+    size_t cap = o->cap ? o->cap : WRITE_BUF_INIT_CAP;
+    while (cap < o->len + len) cap <<= 1;
+    // Only this side grows: the other one may be in flight
+    o->buf = (char*)xrealloc(o->buf, cap);
+    o->cap = cap;
+  }
+  if (o->nsegs > 0) {
+    OutSeg* last = &o->segs[o->nsegs - 1];
+    if (!last->ext) last->len += len;
+    else outbuf_push_seg(o, NULL, o->len, len);
   }
-  memcpy(*buf + c->out_len, data, len);
-  c->out_len += len;
+  memcpy(o->buf + o->len, data, len);
+  o->len += len;
+  o->pending += len;
 
   // Flush when threshold reached
-  if (c->out_len >= FLUSH_THRESHOLD && !c->writing) {
+  if (o->pending >= FLUSH_THRESHOLD && !c->writing) {
     conn_flush_output(c);
   }
 }
 
+// Queue a borrowed value; the connection owns the reference from here on
+static void conn_append_ref(Conn* c, HinotetsuRef* ref) {
+  if (c->closing) {
+    hinotetsu_ref_release_nolock(g_db, ref);
+    return;
+  }
+
+  OutBuf* o = conn_out(c);
+  if (o->nsegs == 0 && o->len > 0) outbuf_push_seg(o, NULL, 0, o->len);
+  outbuf_push_seg(o, ref->value, 0, ref->vlen);
+  if (o->nrefs == o->refs_cap) {
+    o->refs_cap = o->refs_cap ? o->refs_cap * 2 : 16;
+    o->refs = (HinotetsuRef*)xrealloc(o->refs, o->refs_cap * sizeof(HinotetsuRef));
+  }
+  o->refs[o->nrefs++] = *ref;
+  o->pending += ref->vlen;
+}
+
 static void conn_append_str(Conn* c, const char* s) {
   conn_append_output(c, s, strlen(s));
 }
@@ -268,6 +367,7 @@ static void conn_append_str(Conn* c, const char* s) {
 static void write_cb(uv_write_t* req, int status) {
   Conn* c = (Conn*)req->handle->data;
   c->writing = 0;
+  outbuf_reset(&c->out[1 - c->out_active]);
 
   if (status < 0 || c->closing) {
     if (!c->closing) {
@@ -278,27 +378,44 @@ static void write_cb(uv_write_t* req, int status) {
   }
 
   // If data accumulated in the other buffer while writing, flush it
-  if (c->out_len > 0) {
+  if (c->out[c->out_active].pending > 0) {
     conn_flush_output(c);
   }
 }
 
 static void conn_flush_output(Conn* c) {
-  if (c->closing || c->writing || c->out_len == 0) return;
+  if (c->closing || c->writing) return;
 
   int idx = c->out_active;
-  uv_buf_t b = uv_buf_init(c->outbuf[idx], (unsigned int)c->out_len);
+  OutBuf* o = &c->out[idx];
+  if (o->pending == 0) return;
+
+  uv_buf_t one;
+  uv_buf_t* bufs = &one;
+  unsigned int nbufs = 1;
+  if (o->nsegs == 0) {
+    one = uv_buf_init(o->buf, (unsigned int)o->len);
+  } else {
+    if (c->iov_cap < o->nsegs) {
+      c->iov_cap = o->nsegs;
+      c->iov = (uv_buf_t*)xrealloc(c->iov, c->iov_cap * sizeof(uv_buf_t));
+    }
+    for (size_t i = 0; i < o->nsegs; i++) {
+      const OutSeg* seg = &o->segs[i];
+      char* base = seg->ext ? (char*)seg->ext : o->buf + seg->off;
+      c->iov[i] = uv_buf_init(base, (unsigned int)seg->len);
+    }
+    bufs = c->iov;
+    nbufs = (unsigned int)o->nsegs;
+  }
 
   c->writing = 1;
   c->out_active = 1 - idx;  // Swap to other buffer
-  size_t written_len = c->out_len;
-  c->out_len = 0;  // Reset length for new buffer
 
-  int rc = uv_write(&c->write_req, (uv_stream_t*)&c->tcp, &b, 1, write_cb);
+  int rc = uv_write(&c->write_req, (uv_stream_t*)&c->tcp, bufs, nbufs, write_cb);
   if (rc != 0) {
     c->writing = 0;
-    c->out_len = written_len;  // Restore on error
-    c->out_active = idx;
+    c->out_active = idx;  // Restore on error
     c->closing = 1;
     uv_close((uv_handle_t*)&c->tcp, on_closed);
   }
@@ -310,8 +427,9 @@ static void conn_flush_output(Conn* c) {
 static void close_conn(Conn* c) {
   if (!c) return;
   if (c->inbuf) free(c->inbuf);
-  if (c->outbuf[0]) free(c->outbuf[0]);
-  if (c->outbuf[1]) free(c->outbuf[1]);
+  outbuf_free(&c->out[0]);
+  outbuf_free(&c->out[1]);
+  free(c->iov);
   free(c);
 }
 
@@ -337,39 +455,38 @@ static void handle_set(Conn* c, const char* key, int flags, int exptime, const c
   conn_append_str(c, ret == HINOTETSU_OK ? "STORED\r\n" : "SERVER_ERROR out of memory\r\n");
 }
 
+// Values of BORROW_MIN_BYTES or more are written from engine memory,
+// pinned until the write completes. Smaller ones are copied and unpinned
+// at once: a write segment per small value costs more than the copy, and
+// a pinned entry can be neither evicted nor moved. Every GET still takes
+// the pin, since the length is known only once the entry is found.
 static void handle_get(Conn* c, const char* key) {
-  size_t need = 0;
-  char* buf = ensure_get_buf(4096);
-  if (!buf) {
+  HinotetsuRef ref;
+  int ret = hinotetsu_get_ref_nolock(g_db, key, strlen(key), &ref);
+  if (ret == HINOTETSU_ERR_NOMEM) {
     conn_append_str(c, "SERVER_ERROR out of memory\r\n");
     return;
   }
-
-  int ret = hinotetsu_get_into_nolock(g_db, key, strlen(key), buf, g_get_buf_cap, &need);
-
-  if (ret == HINOTETSU_ERR_TOOSMALL) {
-    buf = ensure_get_buf(need);
-    if (!buf) {
-      conn_append_str(c, "SERVER_ERROR out of memory\r\n");
-      return;
-    }
-    ret = hinotetsu_get_into_nolock(g_db, key, strlen(key), buf, g_get_buf_cap, &need);
-  }
-
   if (ret != HINOTETSU_OK) {
     conn_append_str(c, "END\r\n");
     return;
   }
 
   char header[512];
-  int hlen = snprintf(header, sizeof(header), "VALUE %s 0 %zu\r\n", key, need);
+  int hlen = snprintf(header, sizeof(header), "VALUE %s 0 %zu\r\n", key, ref.vlen);
   if (hlen <= 0 || (size_t)hlen >= sizeof(header)) {
+    hinotetsu_ref_release_nolock(g_db, &ref);
     conn_append_str(c, "SERVER_ERROR\r\n");
     return;
   }
 
   conn_append_output(c, header, (size_t)hlen);
-  conn_append_output(c, buf, need);
+  if (ref.vlen >= BORROW_MIN_BYTES) {
+    conn_append_ref(c, &ref);
+  } else {
+    conn_append_output(c, ref.value, ref.vlen);
+    hinotetsu_ref_release_nolock(g_db, &ref);
+  }
   conn_append_str(c, "\r\nEND\r\n");
 }
 
@@ -387,16 +504,27 @@ static void handle_stats(Conn* c) {
     "STAT version %s\r\n"
     "STAT curr_items %zu\r\n"
     "STAT bytes %zu\r\n"
+    "STAT pool_used %zu\r\n"
     "STAT limit_maxbytes %zu\r\n"
+    "STAT huge_page_bytes %zu\r\n"
+    "STAT ready_us %llu\r\n"
+    "STAT prefault_us %llu\r\n"
+    "STAT prefault_bytes %zu\r\n"
+    "STAT released_bytes %zu\r\n"
     "STAT get_hits %zu\r\n"
     "STAT get_misses %zu\r\n"
+    "STAT evictions %zu\r\n"
+    "STAT reclaimed %zu\r\n"
     "STAT bloom_bits %zu\r\n"
     "STAT bloom_fill_pct %.2f\r\n"
     "STAT storage_mode %s\r\n"
     "END\r\n",
     hinotetsu_version(),
-    st.count, st.memory_used, st.pool_size,
+    st.count, st.item_bytes, st.memory_used, st.pool_size, st.huge_page_bytes,
+    (unsigned long long)st.ready_us, (unsigned long long)st.prefault_us, st.prefault_bytes,
+    st.released_bytes,
     st.hits, st.misses,
+    st.evictions, st.reclaimed,
     st.bloom_bits, st.bloom_fill_rate,
     st.mode == 0 ? "hash" : "rbtree");
 
@@ -407,6 +535,139 @@ static void handle_stats(Conn* c) {
   }
 }
 
+static void handle_stats_hashtable(Conn* c) {
+  HinotetsuTableStats* st = (HinotetsuTableStats*)xmalloc(sizeof(*st));
+  hinotetsu_table_stats_nolock(g_db, st);
+
+  char buf[1024];
+  for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+    const HinotetsuTableShardStats* ts = &st->shards[i];
+    int n = snprintf(buf, sizeof(buf),
+      "STAT %u:capacity %u\r\n"
+      "STAT %u:live %u\r\n"
+      "STAT %u:tombstones %u\r\n"
+      "STAT %u:home_slots %u\r\n"
+      "STAT %u:max_displacement %u\r\n"
+      "STAT %u:resizing %u\r\n",
+      i, ts->capacity, i, ts->live, i, ts->tombstones,
+      i, ts->home_slots, i, ts->max_displacement, i, ts->resizing);
+    if (n > 0 && (size_t)n < sizeof(buf)) conn_append_output(c, buf, (size_t)n);
+
+    for (uint32_t d = 0; d < HINOTETSU_PROBE_HIST; d++) {
+      if (ts->probe_hist[d] == 0) continue;
+      n = snprintf(buf, sizeof(buf), "STAT %u:probe_%u%s %llu\r\n",
+                   i, d, d == HINOTETSU_PROBE_HIST - 1u ? "+" : "",
+                   (unsigned long long)ts->probe_hist[d]);
+      if (n > 0 && (size_t)n < sizeof(buf)) conn_append_output(c, buf, (size_t)n);
+    }
+  }
+  conn_append_str(c, "END\r\n");
+  free(st);
+}
+
+// memcached-style "stats slabs"; class ids are 1-based
+static void handle_stats_slabs(Conn* c) {
+  HinotetsuSlabStats* st = (HinotetsuSlabStats*)xmalloc(sizeof(*st));
+  hinotetsu_slab_stats_nolock(g_db, st);
+
+  char buf[1024];
+  uint32_t active = 0;
+  for (uint32_t i = 0; i < st->classes; i++) {
+    const HinotetsuSlabClassStats* cs = &st->cls[i];
+    if (cs->total_pages == 0) continue;
+    active++;
+    uint32_t id = i + 1u;
+    uint32_t per_page = (uint32_t)(cs->total_chunks / cs->total_pages);
+    int n = snprintf(buf, sizeof(buf),
+      "STAT %u:chunk_size %u\r\n"
+      "STAT %u:chunks_per_page %u\r\n"
+      "STAT %u:total_pages %u\r\n"
+      "STAT %u:total_chunks %llu\r\n"
+      "STAT %u:used_chunks %llu\r\n"
+      "STAT %u:free_chunks %llu\r\n"
+      "STAT %u:mem_requested %llu\r\n"
+      "STAT %u:wasted %llu\r\n",
+      id, cs->chunk_size, id, per_page, id, cs->total_pages,
+      id, (unsigned long long)cs->total_chunks,
+      id, (unsigned long long)cs->used_chunks,
+      id, (unsigned long long)cs->free_chunks,
+      id, (unsigned long long)cs->requested_bytes,
+      id, (unsigned long long)cs->wasted_bytes);
+    if (n > 0 && (size_t)n < sizeof(buf)) conn_append_output(c, buf, (size_t)n);
+  }
+  int n = snprintf(buf, sizeof(buf),
+    "STAT active_slabs %u\r\n"
+    "STAT large_pages %u\r\n"
+    "STAT large_items %llu\r\n"
+    "STAT large_bytes %llu\r\n"
+    "STAT large_requested %llu\r\n"
+    "STAT large_free_bytes %llu\r\n"
+    "END\r\n",
+    active, st->large_pages,
+    (unsigned long long)st->large_items,
+    (unsigned long long)st->large_bytes,
+    (unsigned long long)st->large_requested,
+    (unsigned long long)st->large_free_bytes);
+  if (n > 0 && (size_t)n < sizeof(buf)) conn_append_output(c, buf, (size_t)n);
+  free(st);
+}
+
+// Turn the timing wheels from the loop; each tick frees a bounded number of
+// expired entries per shard so request latency is not disturbed
+static void expire_timer_cb(uv_timer_t* t) {
+  (void)t;
+  clock_update();
+  hinotetsu_expire_nolock(g_db, HINOTETSU_EXPIRE_BATCH);
+}
+
+static void slab_automove_timer_cb(uv_timer_t* t) {
+  (void)t;
+  if (g_slab_automove) hinotetsu_slab_automove_nolock(g_db);
+}
+
+// "stats" reports the huge page coverage found by the last scan
+static void huge_scan_timer_cb(uv_timer_t* t) {
+  (void)t;
+  hinotetsu_huge_page_scan_nolock(g_db);
+}
+
+// "slabs reassign <src> <dst>" (1-based ids, src -1 = any class) and
+// "slabs automove <0|1>", with memcached's replies
+static void handle_slabs(Conn* c, const char* args) {
+  char* end = NULL;
+  if (strncmp(args, "reassign", 8) == 0 && isspace((unsigned char)args[8])) {
+    long src = strtol(args + 8, &end, 10);
+    long dst = strtol(end, &end, 10);
+    if (*skip_spaces(end) != '\0') {
+      conn_append_str(c, "CLIENT_ERROR bad command\r\n");
+      return;
+    }
+    HinotetsuSlabStats* st = (HinotetsuSlabStats*)xmalloc(sizeof(*st));
+    hinotetsu_slab_stats_nolock(g_db, st);
+    long classes = (long)st->classes;
+    free(st);
+    if (src == dst) {
+      conn_append_str(c, "SAME\r\n");
+    } else if (dst < 1 || dst > classes || src == 0 || src < -1 || src > classes) {
+      conn_append_str(c, "BADCLASS\r\n");
+    } else if (hinotetsu_slab_reassign_nolock(g_db, src < 0 ? -1 : (int)(src - 1), (uint32_t)(dst - 1)) == 0) {
+      conn_append_str(c, "NOSPARE\r\n");
+    } else {
+      conn_append_str(c, "OK\r\n");
+    }
+  } else if (strncmp(args, "automove", 8) == 0 && isspace((unsigned char)args[8])) {
+    long on = strtol(args + 8, &end, 10);
+    if (end == args + 8 || *skip_spaces(end) != '\0' || on < 0 || on > 1) {
+      conn_append_str(c, "CLIENT_ERROR bad command\r\n");
+      return;
+    }
+    g_slab_automove = (int)on;
+    conn_append_str(c, "OK\r\n");
+  } else {
+    conn_append_str(c, "CLIENT_ERROR bad command\r\n");
+  }
+}
+
 static void handle_flush(Conn* c) {
   hinotetsu_flush_nolock(g_db);
   conn_append_str(c, "OK\r\n");
@@ -498,11 +759,18 @@ static void parse_and_dispatch(Conn* c) {
     }
     else if (strcmp(cmd, "stats") == 0) {
       const char* p = skip_spaces(line + 5);
-      if (*p != '\0') {
+      if (*p == '\0') {
+        handle_stats(c);
+      } else if (strncmp(p, "hashtable", 9) == 0 && *skip_spaces(p + 9) == '\0') {
+        handle_stats_hashtable(c);
+      } else if (strncmp(p, "slabs", 5) == 0 && *skip_spaces(p + 5) == '\0') {
+        handle_stats_slabs(c);
+      } else {
         conn_append_str(c, "CLIENT_ERROR bad command\r\n");
-        continue;
       }
-      handle_stats(c);
+    }
+    else if (strcmp(cmd, "slabs") == 0) {
+      handle_slabs(c, skip_spaces(line + 5));
     }
     else if (strcmp(cmd, "flush_all") == 0) {
       const char* p = skip_spaces(line + 9);
@@ -528,6 +796,7 @@ static void parse_and_dispatch(Conn* c) {
 
 static void read_cb(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
   Conn* c = (Conn*)stream->data;
+  clock_update();
 
   if (nread <= 0) {
     free(buf->base);
@@ -571,12 +840,13 @@ static void on_new_conn(uv_stream_t* server, int status) {
   c->inbuf = (char*)malloc(c->in_cap);
   if (!c->inbuf) { free(c); return; }
 
-  c->out_cap = WRITE_BUF_INIT_CAP;
-  c->outbuf[0] = (char*)malloc(c->out_cap);
-  c->outbuf[1] = (char*)malloc(c->out_cap);
-  if (!c->outbuf[0] || !c->outbuf[1]) {
-    if (c->outbuf[0]) free(c->outbuf[0]);
-    if (c->outbuf[1]) free(c->outbuf[1]);
+  for (int i = 0; i < 2; i++) {
+    c->out[i].cap = WRITE_BUF_INIT_CAP;
+    c->out[i].buf = (char*)malloc(c->out[i].cap);
+  }
+  if (!c->out[0].buf || !c->out[1].buf) {
+    free(c->out[0].buf);
+    free(c->out[1].buf);
     free(c->inbuf);
     free(c);
     return;
@@ -604,29 +874,42 @@ static void on_new_conn(uv_stream_t* server, int status) {
 // -----------------------------
 static void usage(const char* argv0) {
   fprintf(stderr,
-    "Usage: %s [-p port] [-m memory_mb]\n"
+    "Usage: %s [-p port] [-m memory_mb] [-L] [-T threads] [-B] [-E]\n"
     "  -p port       TCP port (default: 11211)\n"
-    "  -m mb         Memory in MB (default: 64)\n",
+    "  -m mb         Memory in MB (default: 64)\n"
+    "  -L            Back memory and hash tables with 2MB huge pages\n"
+    "  -T threads    Threads pre-faulting memory at startup (default: 1, 0 = one per CPU)\n"
+    "  -B            Serve at once while memory is pre-faulted in the background\n"
+    "  -E            Elastic memory: grow on demand up to -m, return idle memory to the OS\n",
     argv0);
 }
 
-static void print_banner(int port, int memory_mb) {
+static void print_banner(int port, int memory_mb, int huge_pages) {
   fprintf(stderr, "\n");
   fprintf(stderr, "  ╦ ╦╦╔╗╔╔═╗╔╦╗╔═╗╔╦╗╔═╗╦ ╦\n");
   fprintf(stderr, "  ╠═╣║║║║║ ║ ║ ║╣  ║ ╚═╗║ ║\n");
   fprintf(stderr, "  ╩ ╩╩╝╚═╚═╝ ╩ ╚═╝ ╩ ╚═╝╚═╝\n");
   fprintf(stderr, "  High Performance Key-Value Store (libuv)\n");
   fprintf(stderr, "  Version %s\n\n", hinotetsu_version());
-  fprintf(stderr, "  Port: %d | Memory: %d MB\n\n", port, memory_mb);
+  fprintf(stderr, "  Port: %d | Memory: %d MB%s\n\n", port, memory_mb,
+          huge_pages ? " | Huge pages" : "");
 }
 
 int main(int argc, char** argv) {
   int port = 11211;
   int memory_mb = 64;
+  int huge_pages = 0;
+  int prefault_threads = 1;
+  int prefault_async = 0;
+  int elastic = 0;
 
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) port = atoi(argv[++i]);
     else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) memory_mb = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-L") == 0) huge_pages = 1;
+    else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) prefault_threads = atoi(argv[++i]);
+    else if (strcmp(argv[i], "-B") == 0) prefault_async = 1;
+    else if (strcmp(argv[i], "-E") == 0) elastic = 1;
     else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) { usage(argv[0]); return 0; }
     else { usage(argv[0]); return 1; }
   }
@@ -635,13 +918,33 @@ int main(int argc, char** argv) {
   signal(SIGPIPE, SIG_IGN);
 #endif
 
-  size_t pool_bytes = (size_t)memory_mb * 1024u * 1024u;
-  g_db = hinotetsu_open(pool_bytes);
+  HinotetsuOptions opt;
+  hinotetsu_options_init(&opt);
+  opt.pool_size = (size_t)memory_mb * 1024u * 1024u;
+  opt.huge_pages = huge_pages;
+  opt.prefault_threads = prefault_threads > 0 ? (uint32_t)prefault_threads : 0u;
+  opt.prefault_async = prefault_async;
+  opt.elastic = elastic;
+  g_db = hinotetsu_open_ex(&opt);
   if (!g_db) die("Failed to initialize Hinotetsu");
-
-  // Pre-allocate GET buffer
-  g_get_buf = (char*)malloc(64 * 1024);
-  g_get_buf_cap = g_get_buf ? 64 * 1024 : 0;
+  clock_init();
+  clock_update();
+
+  uv_timer_t expire_timer;
+  uv_timer_init(uv_default_loop(), &expire_timer);
+  uv_timer_start(&expire_timer, expire_timer_cb, EXPIRE_INTERVAL_MS, EXPIRE_INTERVAL_MS);
+
+  uv_timer_t automove_timer;
+  uv_timer_init(uv_default_loop(), &automove_timer);
+  uv_timer_start(&automove_timer, slab_automove_timer_cb,
+                 SLAB_AUTOMOVE_INTERVAL_MS, SLAB_AUTOMOVE_INTERVAL_MS);
+
+  uv_timer_t huge_scan_timer;
+  uv_timer_init(uv_default_loop(), &huge_scan_timer);
+  if (huge_pages) {
+    uv_timer_start(&huge_scan_timer, huge_scan_timer_cb,
+                   HUGE_SCAN_INTERVAL_MS, HUGE_SCAN_INTERVAL_MS);
+  }
 
   uv_tcp_t server;
   uv_tcp_init(uv_default_loop(), &server);
@@ -651,12 +954,16 @@ int main(int argc, char** argv) {
   if (uv_tcp_bind(&server, (const struct sockaddr*)&addr4, 0) != 0) die("uv_tcp_bind failed");
   if (uv_listen((uv_stream_t*)&server, 1024, on_new_conn) != 0) die("uv_listen failed");
 
-  print_banner(port, memory_mb);
+  print_banner(port, memory_mb, huge_pages);
+  HinotetsuStats st;
+  hinotetsu_stats_nolock(g_db, &st);
+  fprintf(stderr, "Ready in %.1f ms%s\n", (double)st.ready_us / 1000.0,
+          elastic ? ", memory grows on demand" :
+          st.prefault_us ? "" : ", pre-faulting memory in the background");
   fprintf(stderr, "Listening on port %d...\n\n", port);
 
   uv_run(uv_default_loop(), UV_RUN_DEFAULT);
 
-  if (g_get_buf) free(g_get_buf);
   hinotetsu_close(g_db);
   return 0;
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #   ./run_tests.sh ttl      # Run only TTL tests
 #   ./run_tests.sh stress   # Run only stress tests
 #   ./run_tests.sh protocol # Run protocol tests (requires running daemon)
+#   CFLAGS=-DHINOTETSU_TABLE=1 ./run_tests.sh  # Build with extra compile flags
 
 set -e
 
@@ -29,14 +30,14 @@ mkdir -p "$BUILD_DIR"
 
 # Compile library first
 echo -e "${YELLOW}Compiling hinotetsu3 library...${NC}"
-gcc -O2 -c "$PROJECT_DIR/hinotetsu3.c" -o "$BUILD_DIR/hinotetsu3.o" -lpthread
+gcc -O2 $CFLAGS -c "$PROJECT_DIR/hinotetsu3.c" -o "$BUILD_DIR/hinotetsu3.o" -lpthread
 echo "  Done."
 echo ""
 
 compile_test() {
     local name=$1
     echo -e "${YELLOW}Compiling test_$name...${NC}"
-    gcc -O2 -o "$BUILD_DIR/test_$name" \
+    gcc -O2 $CFLAGS -o "$BUILD_DIR/test_$name" \
         "$SCRIPT_DIR/test_$name.c" \
         "$BUILD_DIR/hinotetsu3.o" \
         -lpthread
@@ -21,6 +21,44 @@ int test_open_close(void) {
     TEST_PASS();
 }
 
+// Test: Huge page backing falls back when 2MB pages are unavailable
+int test_open_huge_pages(void) {
+    TEST_START("open_huge_pages");
+
+    HinotetsuOptions opt;
+    hinotetsu_options_init(&opt);
+    opt.pool_size = 128 * 1024 * 1024;
+
+    Hinotetsu* test_db = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(test_db != NULL, "hinotetsu_open_ex should return non-NULL");
+    HinotetsuStats stats;
+    hinotetsu_stats(test_db, &stats);
+    TEST_ASSERT_EQ(0, stats.huge_page_bytes, "No huge pages unless asked for");
+    hinotetsu_close(test_db);
+
+    opt.huge_pages = 1;
+    test_db = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(test_db != NULL, "Huge page open should succeed with or without huge pages");
+
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(test_db, "huge", 4, "pages", 5, 0), "SET should succeed");
+    char* val = NULL;
+    size_t vlen = 0;
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_get(test_db, "huge", 4, &val, &vlen), "GET should succeed");
+    TEST_ASSERT(vlen == 5 && memcmp(val, "pages", 5) == 0, "Value should match");
+    free(val);
+
+    // Only the arena is large enough for huge pages at this size
+    size_t scanned = hinotetsu_huge_page_scan(test_db);
+    hinotetsu_stats(test_db, &stats);
+    TEST_ASSERT_EQ(scanned, stats.huge_page_bytes, "Stats should report the last scan");
+    TEST_ASSERT(stats.huge_page_bytes <= stats.pool_size, "Huge pages bounded by the arena");
+    TEST_ASSERT(stats.huge_page_bytes % (2 * 1024 * 1024) == 0, "Whole 2MB pages");
+    printf("  Huge page bytes: %zu of %zu\n", stats.huge_page_bytes, stats.pool_size);
+
+    hinotetsu_close(test_db);
+    TEST_PASS();
+}
+
 // Test: Version string
 int test_version(void) {
     TEST_START("version");
@@ -79,6 +117,41 @@ int test_set_overwrite(void) {
     TEST_PASS();
 }
 
+// Test: An overwrite that cannot be stored keeps the old value
+int test_set_overwrite_nomem(void) {
+    TEST_START("set_overwrite_nomem");
+
+    Hinotetsu* small = hinotetsu_open(8 * 1024 * 1024);
+    TEST_ASSERT(small != NULL, "hinotetsu_open should return non-NULL");
+
+    const char* key = "keep_key";
+    const char* value = "old_value";
+    int ret = hinotetsu_set(small, key, strlen(key), value, strlen(value), 0);
+    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "First SET should return OK");
+
+    // No class or extent can hold a value larger than the pool
+    HinotetsuStats stats;
+    hinotetsu_stats(small, &stats);
+    size_t big_len = stats.pool_size + 1;
+    char* big = malloc(big_len);
+    TEST_ASSERT(big != NULL, "malloc should succeed");
+    memset(big, 'b', big_len);
+    ret = hinotetsu_set(small, key, strlen(key), big, big_len, 0);
+    free(big);
+
+    char buf[64];
+    size_t len = 0;
+    int get_ret = hinotetsu_get_into(small, key, strlen(key), buf, sizeof(buf), &len);
+    hinotetsu_close(small);
+
+    TEST_ASSERT_EQ(HINOTETSU_ERR_NOMEM, ret, "Oversized SET should return NOMEM");
+    TEST_ASSERT_EQ(HINOTETSU_OK, get_ret, "Old value should survive the failed SET");
+    TEST_ASSERT_EQ(strlen(value), len, "Old value length should be unchanged");
+    TEST_ASSERT_STR_EQ(value, buf, len, "Old value should be unchanged");
+
+    TEST_PASS();
+}
+
 // Test: GET non-existent key
 int test_get_notfound(void) {
     TEST_START("get_notfound");
@@ -226,6 +299,99 @@ int test_long_key(void) {
     TEST_PASS();
 }
 
+// Test: Every key length up to 200 (covers each hash code path), with keys
+// that differ only in their last byte
+int test_key_lengths(void) {
+    TEST_START("key_lengths");
+
+    char key[201];
+    char buf[16];
+    size_t len = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t klen = 1; klen <= 200; klen++) {
+            memset(key, 'h', klen);
+            for (int last = 0; last < 2; last++) {
+                key[klen - 1] = (char)('a' + last);
+                snprintf(buf, sizeof(buf), "%zu%c", klen, 'a' + last);
+                if (pass == 0) {
+                    int ret = hinotetsu_set(db, key, klen, buf, strlen(buf), 0);
+                    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "SET should return OK");
+                    continue;
+                }
+                char out[16];
+                int ret = hinotetsu_get_into(db, key, klen, out, sizeof(out), &len);
+                TEST_ASSERT_EQ(HINOTETSU_OK, ret, "GET should return OK");
+                TEST_ASSERT_EQ(strlen(buf), len, "Value length should match");
+                TEST_ASSERT_STR_EQ(buf, out, len, "Value should match its key");
+            }
+        }
+    }
+
+    TEST_PASS();
+}
+
+// Test: Borrowed references survive overwrite, delete and flush
+int test_get_ref(void) {
+    TEST_START("get_ref");
+
+    hinotetsu_flush(db);
+
+    HinotetsuRef ref;
+    TEST_ASSERT_EQ(HINOTETSU_ERR_NOTFOUND, hinotetsu_get_ref(db, "ref:none", 8, &ref),
+                   "Missing key should not be found");
+
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(db, "ref:a", 5, "first", 5, 0), "SET should succeed");
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_get_ref(db, "ref:a", 5, &ref), "GET_REF should succeed");
+    TEST_ASSERT(ref.vlen == 5 && memcmp(ref.value, "first", 5) == 0, "Reference should see the value");
+
+    // The pinned value stays intact while the key moves on
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(db, "ref:a", 5, "second", 6, 0), "Overwrite should succeed");
+    char buf[16];
+    size_t len = 0;
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_get_into(db, "ref:a", 5, buf, sizeof(buf), &len), "GET should succeed");
+    TEST_ASSERT(len == 6 && memcmp(buf, "second", 6) == 0, "GET should see the new value");
+    TEST_ASSERT(ref.vlen == 5 && memcmp(ref.value, "first", 5) == 0, "Reference should keep the old value");
+    hinotetsu_ref_release(db, &ref);
+    TEST_ASSERT(ref.value == NULL, "Release should clear the reference");
+
+    // Large values are borrowed in place as well
+    size_t big_len = 100 * 1024;
+    char* big = malloc(big_len);
+    TEST_ASSERT(big != NULL, "malloc should succeed");
+    memset(big, 'B', big_len);
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(db, "ref:big", 7, big, big_len, 0), "SET should succeed");
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_get_ref(db, "ref:big", 7, &ref), "GET_REF should succeed");
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_delete(db, "ref:big", 7), "DELETE should succeed");
+    TEST_ASSERT(ref.vlen == big_len && memcmp(ref.value, big, big_len) == 0, "Deleted value should stay readable");
+
+    // More references than an entry counts fall back to copies
+    HinotetsuRef refs[300];
+    TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(db, "ref:hot", 7, "hot", 3, 0), "SET should succeed");
+    int ok = 0;
+    for (int i = 0; i < 300; i++) {
+        if (hinotetsu_get_ref(db, "ref:hot", 7, &refs[i]) == HINOTETSU_OK &&
+            refs[i].vlen == 3 && memcmp(refs[i].value, "hot", 3) == 0) ok++;
+    }
+    TEST_ASSERT_EQ(300, ok, "Every reference should see the value");
+
+    hinotetsu_flush(db);
+    TEST_ASSERT(memcmp(ref.value, big, big_len) == 0, "Flush should leave pinned values alone");
+    TEST_ASSERT(memcmp(refs[0].value, "hot", 3) == 0, "Flush should leave pinned values alone");
+    HinotetsuStats stats;
+    hinotetsu_stats(db, &stats);
+    TEST_ASSERT_EQ(0, stats.count, "Flush should drop every key");
+    TEST_ASSERT(stats.item_bytes > big_len, "Pinned entries still hold their memory");
+
+    hinotetsu_ref_release(db, &ref);
+    for (int i = 0; i < 300; i++) hinotetsu_ref_release(db, &refs[i]);
+    hinotetsu_stats(db, &stats);
+    TEST_ASSERT_EQ(0, stats.item_bytes, "Memory should be freed by the last release");
+    free(big);
+
+    TEST_PASS();
+}
+
 // Test: Large value
 int test_large_value(void) {
     TEST_START("large_value");
@@ -251,6 +417,103 @@ int test_large_value(void) {
     TEST_PASS();
 }
 
+// Test: Batched SET/GET/DELETE across shards
+int test_batch_ops(void) {
+    TEST_START("batch_ops");
+
+    hinotetsu_flush(db);
+
+    // More keys than the on-stack plan holds, plus an empty one
+    enum { N = 600 };
+    static char kbuf[N][16], vbuf[N][24];
+    static const char* keys[N];
+    static const char* values[N];
+    static size_t klens[N], vlens[N];
+    static int results[N];
+    static HinotetsuRef refs[N];
+    for (int i = 0; i < N; i++) {
+        klens[i] = (size_t)snprintf(kbuf[i], sizeof(kbuf[i]), "batch:%d", i);
+        vlens[i] = (size_t)snprintf(vbuf[i], sizeof(vbuf[i]), "value-%d", i * 7);
+        keys[i] = kbuf[i];
+        values[i] = vbuf[i];
+    }
+    klens[N - 1] = 0;
+
+    TEST_ASSERT_EQ(N - 1, hinotetsu_mset(db, keys, klens, values, vlens, N, 0, results),
+                   "MSET should store every key");
+    TEST_ASSERT_EQ(HINOTETSU_ERR_IO, results[N - 1], "Empty key should be rejected");
+    int ok = 0;
+    for (int i = 0; i < N - 1; i++) {
+        char buf[24];
+        size_t len = 0;
+        if (hinotetsu_get_into(db, keys[i], klens[i], buf, sizeof(buf), &len) == HINOTETSU_OK &&
+            len == vlens[i] && memcmp(buf, values[i], len) == 0) ok++;
+    }
+    TEST_ASSERT_EQ(N - 1, ok, "GET should see every batched value");
+
+    // Delete every third key, then read them all back in request order
+    static const char* dkeys[N];
+    static size_t dklens[N];
+    size_t nd = 0;
+    for (int i = 0; i < N - 1; i += 3) {
+        dkeys[nd] = keys[i];
+        dklens[nd++] = klens[i];
+    }
+    TEST_ASSERT_EQ(nd, hinotetsu_mdelete(db, dkeys, dklens, nd, NULL), "MDELETE should remove every key");
+    TEST_ASSERT_EQ(0, hinotetsu_mdelete(db, dkeys, dklens, nd, results), "Deleted keys should be gone");
+    TEST_ASSERT_EQ(HINOTETSU_ERR_NOTFOUND, results[0], "Second MDELETE should miss");
+
+    size_t hits = hinotetsu_mget(db, keys, klens, N, refs, results);
+    TEST_ASSERT_EQ(N - 1 - nd, hits, "MGET should hit the remaining keys");
+    ok = 0;
+    for (int i = 0; i < N - 1; i++) {
+        if (i % 3 == 0) {
+            if (results[i] == HINOTETSU_ERR_NOTFOUND && refs[i].value == NULL) ok++;
+        } else if (results[i] == HINOTETSU_OK && refs[i].vlen == vlens[i] &&
+                   memcmp(refs[i].value, values[i], vlens[i]) == 0) {
+            ok++;
+        }
+    }
+    TEST_ASSERT_EQ(N - 1, ok, "MGET should answer every key in request order");
+    TEST_ASSERT_EQ(HINOTETSU_ERR_IO, results[N - 1], "Empty key should be rejected");
+
+    // Borrowed values outlive a flush until released
+    hinotetsu_flush(db);
+    TEST_ASSERT(memcmp(refs[1].value, values[1], vlens[1]) == 0, "Flush should leave pinned values alone");
+    hinotetsu_mrelease(db, refs, N);
+    TEST_ASSERT(refs[1].value == NULL, "Release should clear the references");
+
+    TEST_PASS();
+}
+
+// Test: Overwrite across inline and out-of-line value sizes
+int test_overwrite_sizes(void) {
+    TEST_START("overwrite_sizes");
+
+    const char* key = "resize_value_key";
+    const size_t sizes[] = {10, 10000, 100, 4000, 0, 300};
+    char* value = malloc(10000);
+    TEST_ASSERT(value != NULL, "malloc should succeed");
+    char* out = malloc(10000);
+    TEST_ASSERT(out != NULL, "malloc should succeed");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        memset(value, 'a' + (int)i, sizes[i]);
+        int ret = hinotetsu_set(db, key, strlen(key), value, sizes[i], 0);
+        TEST_ASSERT_EQ(HINOTETSU_OK, ret, "SET should return OK");
+
+        size_t out_len = 0;
+        ret = hinotetsu_get_into(db, key, strlen(key), out, 10000, &out_len);
+        TEST_ASSERT_EQ(HINOTETSU_OK, ret, "GET_INTO should return OK");
+        TEST_ASSERT_EQ(sizes[i], out_len, "Value length should follow the last SET");
+        TEST_ASSERT_STR_EQ(value, out, out_len, "Value content should follow the last SET");
+    }
+
+    free(value);
+    free(out);
+    TEST_PASS();
+}
+
 // Test: FLUSH
 int test_flush(void) {
     TEST_START("flush");
@@ -304,6 +567,70 @@ int test_stats(void) {
     TEST_PASS();
 }
 
+// Test: slab class sizing and per-class accounting
+int test_slab_stats(void) {
+    TEST_START("slab_stats");
+
+    hinotetsu_flush(db);
+
+    HinotetsuSlabStats st;
+    hinotetsu_slab_stats(db, &st);
+    TEST_ASSERT(st.classes > 1 && st.classes <= HINOTETSU_SLAB_MAX_CLASSES, "Class count in range");
+    for (uint32_t c = 1; c < st.classes; c++) {
+        TEST_ASSERT(st.cls[c].chunk_size > st.cls[c - 1].chunk_size, "Chunk sizes should increase");
+        TEST_ASSERT(st.cls[c].chunk_size % 8 == 0, "Chunk sizes should be 8-byte aligned");
+    }
+    TEST_ASSERT_EQ(1u << HINOTETSU_SLAB_MAX_SHIFT, st.cls[st.classes - 1].chunk_size,
+                   "Largest class should be the slab limit");
+
+    // A 260-byte value must not be rounded up to the next power of two
+    char value[260];
+    memset(value, 'v', sizeof(value));
+    const int n = 1000;
+    for (int i = 0; i < n; i++) {
+        char key[32];
+        int klen = snprintf(key, sizeof(key), "slab:%d", i);
+        TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(db, key, klen, value, sizeof(value), 0), "SET should succeed");
+    }
+
+    hinotetsu_slab_stats(db, &st);
+    uint64_t used = 0;
+    int used_classes = 0;
+    for (uint32_t c = 0; c < st.classes; c++) {
+        HinotetsuSlabClassStats* cs = &st.cls[c];
+        TEST_ASSERT_EQ(cs->total_chunks, cs->used_chunks + cs->free_chunks, "Chunks should be used or free");
+        TEST_ASSERT_EQ(cs->used_chunks * cs->chunk_size - cs->requested_bytes, cs->wasted_bytes,
+                       "Waste should be chunk bytes minus requested bytes");
+        if (cs->used_chunks == 0) continue;
+        used += cs->used_chunks;
+        used_classes++;
+        TEST_ASSERT(cs->chunk_size < 512, "260B value should fit below a 512B chunk");
+        TEST_ASSERT(cs->wasted_bytes * 4 < cs->used_chunks * cs->chunk_size, "Waste should stay under 25%");
+    }
+    TEST_ASSERT_EQ(n, used, "One chunk per inline entry");
+    TEST_ASSERT_EQ(1, used_classes, "Same-size entries should share a class");
+
+    uint64_t chunk_bytes = 0;
+    for (uint32_t c = 0; c < st.classes; c++) chunk_bytes += st.cls[c].used_chunks * st.cls[c].chunk_size;
+    HinotetsuStats stats;
+    hinotetsu_stats(db, &stats);
+    TEST_ASSERT_EQ(chunk_bytes, stats.item_bytes, "Item bytes should match the used chunks");
+
+    // Deleting returns chunks to the free lists
+    for (int i = 0; i < n; i++) {
+        char key[32];
+        int klen = snprintf(key, sizeof(key), "slab:%d", i);
+        hinotetsu_delete(db, key, klen);
+    }
+    hinotetsu_slab_stats(db, &st);
+    for (uint32_t c = 0; c < st.classes; c++) {
+        TEST_ASSERT_EQ(0, st.cls[c].used_chunks, "No chunks in use after deletes");
+        TEST_ASSERT_EQ(0, st.cls[c].requested_bytes, "No requested bytes after deletes");
+    }
+
+    TEST_PASS();
+}
+
 // Test: Hit/Miss statistics
 int test_hit_miss_stats(void) {
     TEST_START("hit_miss_stats");
@@ -351,9 +678,11 @@ int main(void) {
 
     // Run tests
     RUN_TEST(test_open_close);
+    RUN_TEST(test_open_huge_pages);
     RUN_TEST(test_version);
     RUN_TEST(test_set_get_simple);
     RUN_TEST(test_set_overwrite);
+    RUN_TEST(test_set_overwrite_nomem);
     RUN_TEST(test_get_notfound);
     RUN_TEST(test_delete);
     RUN_TEST(test_delete_notfound);
@@ -362,9 +691,14 @@ int main(void) {
     RUN_TEST(test_binary_data);
     RUN_TEST(test_empty_value);
     RUN_TEST(test_long_key);
+    RUN_TEST(test_key_lengths);
     RUN_TEST(test_large_value);
+    RUN_TEST(test_get_ref);
+    RUN_TEST(test_batch_ops);
+    RUN_TEST(test_overwrite_sizes);
     RUN_TEST(test_flush);
     RUN_TEST(test_stats);
+    RUN_TEST(test_slab_stats);
     RUN_TEST(test_hit_miss_stats);
 
     hinotetsu_close(db);
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
@@ -307,6 +308,90 @@ int test_protocol_pipeline(void) {
     TEST_PASS();
 }
 
+// Read until want bytes arrived or the server goes quiet for a second
+static size_t recv_exact(char* buf, size_t want) {
+    struct timeval tv = {1, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    size_t got = 0;
+    while (got < want) {
+        ssize_t n = recv(sock, buf + got, want - got, 0);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    tv.tv_sec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return got;
+}
+
+// Test: Replies queued while an earlier write is in flight all arrive, in order
+int test_protocol_pipeline_write(void) {
+    TEST_START("protocol_pipeline_write");
+
+    // A value large enough that its reply is still being written when the
+    // commands after it are handled
+    const size_t BIG = 100 * 1024;
+    char* value = malloc(BIG + 1);
+    random_string(value, BIG + 1);
+
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "set pipe_big 0 0 %zu\r\n", BIG);
+    send(sock, cmd, strlen(cmd), 0);
+    send(sock, value, BIG, 0);
+    send(sock, "\r\n", 2, 0);
+    memset(recv_buf, 0, sizeof(recv_buf));
+    TEST_ASSERT_EQ(8, recv_exact(recv_buf, 8), "SET big should reply");
+    TEST_ASSERT(strncmp(recv_buf, "STORED\r\n", 8) == 0, "SET big should return STORED");
+
+    const char* pipeline =
+        "get pipe_big\r\n"
+        "set pipe_big 0 0 5\r\nhello\r\n"
+        "get pipe_big\r\n";
+    char header[64];
+    int hlen = snprintf(header, sizeof(header), "VALUE pipe_big 0 %zu\r\n", BIG);
+    const char* tail = "\r\nEND\r\nSTORED\r\nVALUE pipe_big 0 5\r\nhello\r\nEND\r\n";
+    size_t want = (size_t)hlen + BIG + strlen(tail);
+    char* reply = malloc(want);
+    send(sock, pipeline, strlen(pipeline), 0);
+    size_t got = recv_exact(reply, want);
+
+    int intact = got == want &&
+                 memcmp(reply, header, (size_t)hlen) == 0 &&
+                 memcmp(reply + hlen, value, BIG) == 0 &&
+                 memcmp(reply + hlen + BIG, tail, strlen(tail)) == 0;
+    free(reply);
+    free(value);
+    TEST_ASSERT_EQ(want, got, "Every pipelined reply should arrive");
+    TEST_ASSERT(intact, "Pipelined replies should arrive intact and in order");
+
+    // Many small replies, flushed while earlier ones are in flight
+    const int GETS = 2000;
+    char small[101];
+    random_string(small, sizeof(small));
+    send_set("pipe_small", small, 0);
+    hlen = snprintf(header, sizeof(header), "VALUE pipe_small 0 %zu\r\n", strlen(small));
+    size_t one = (size_t)hlen + strlen(small) + strlen("\r\nEND\r\n");
+    const char* get = "get pipe_small\r\n";
+    char* gets = malloc((size_t)GETS * strlen(get));
+    for (int i = 0; i < GETS; i++) memcpy(gets + (size_t)i * strlen(get), get, strlen(get));
+    send(sock, gets, (size_t)GETS * strlen(get), 0);
+    free(gets);
+
+    want = (size_t)GETS * one;
+    reply = malloc(want);
+    got = recv_exact(reply, want);
+    int bad = 0;
+    for (int i = 0; i < GETS && (size_t)(i + 1) * one <= got; i++) {
+        const char* r = reply + (size_t)i * one;
+        if (memcmp(r, header, (size_t)hlen) != 0 ||
+            memcmp(r + hlen, small, strlen(small)) != 0) bad++;
+    }
+    free(reply);
+    TEST_ASSERT_EQ(want, got, "Every pipelined GET should be answered");
+    TEST_ASSERT_EQ(0, bad, "Pipelined GET replies should be intact");
+
+    TEST_PASS();
+}
+
 int main(int argc, char* argv[]) {
     printf("Hinotetsu Protocol Tests\n");
     printf("========================================\n");
@@ -342,6 +427,7 @@ int main(int argc, char* argv[]) {
     RUN_TEST(test_protocol_flush);
     RUN_TEST(test_protocol_invalid);
     RUN_TEST(test_protocol_pipeline);
+    RUN_TEST(test_protocol_pipeline_write);
 
     close(sock);
 
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <unistd.h>
 #include "test_helper.h"
 #include "../hinotetsu3.h"
 
@@ -202,6 +203,102 @@ int test_concurrent_access(void) {
     TEST_PASS();
 }
 
+// Test: Readers share the shard locks and leave resizes to writers
+typedef struct {
+    Hinotetsu* db;
+    int thread_id;
+    int num_keys;
+    int num_ops;
+    int found;
+} ReadArg;
+
+static void* read_worker(void* arg) {
+    ReadArg* ra = (ReadArg*)arg;
+    char key[32];
+    char buf[64];
+    size_t len;
+
+    unsigned idx = (unsigned)ra->thread_id * 7919u;
+    for (int i = 0; i < ra->num_ops; i++) {
+        idx = (idx + 104729u) % (unsigned)ra->num_keys;
+        snprintf(key, sizeof(key), "reader_%u", idx);
+        if (hinotetsu_get_into(ra->db, key, strlen(key), buf, sizeof(buf), &len) == HINOTETSU_OK) ra->found++;
+    }
+    return NULL;
+}
+
+int test_concurrent_reads(void) {
+    TEST_START("concurrent_reads");
+
+    const int MAX_KEYS = 2000000;
+    const int OPS_PER_THREAD = 200000;
+    char key[32];
+
+    // A database of its own: the grown tables would outlast a flush
+    Hinotetsu* rdb = hinotetsu_open(256 * 1024 * 1024);
+    TEST_ASSERT(rdb != NULL, "hinotetsu_open should succeed");
+
+    // Fill until some shard is part-way through growing its table
+    HinotetsuStats stats;
+    int num_keys = 0;
+    do {
+        for (int i = 0; i < 1000; i++, num_keys++) {
+            snprintf(key, sizeof(key), "reader_%d", num_keys);
+            hinotetsu_set(rdb, key, strlen(key), "v", 1, 0);
+        }
+        hinotetsu_stats(rdb, &stats);
+    } while (stats.resize_in_progress == 0 && num_keys < MAX_KEYS);
+    TEST_ASSERT(stats.resize_in_progress > 0, "A table should be resizing");
+    size_t resizing = stats.resize_in_progress;
+
+    for (int nthreads = 1; nthreads <= 4; nthreads *= 2) {
+        pthread_t threads[4];
+        ReadArg args[4];
+        HinotetsuStats before, after;
+        hinotetsu_stats(rdb, &before);
+
+        long long start = current_time_ms();
+        for (int i = 0; i < nthreads; i++) {
+            args[i].db = rdb;
+            args[i].thread_id = i;
+            args[i].num_keys = num_keys;
+            args[i].num_ops = OPS_PER_THREAD;
+            args[i].found = 0;
+            pthread_create(&threads[i], NULL, read_worker, &args[i]);
+        }
+        int found = 0;
+        for (int i = 0; i < nthreads; i++) {
+            pthread_join(threads[i], NULL);
+            found += args[i].found;
+        }
+        long long elapsed = current_time_ms() - start;
+        hinotetsu_stats(rdb, &after);
+
+        int total = nthreads * OPS_PER_THREAD;
+        printf("  %d reader(s): %d gets in %lld ms (%.0f gets/sec)\n",
+               nthreads, total, elapsed, total * 1000.0 / (elapsed > 0 ? elapsed : 1));
+        TEST_ASSERT_EQ(total, found, "Every key should be found mid-resize");
+        TEST_ASSERT_EQ((size_t)total, after.hits - before.hits, "Per-thread hit counters should add up");
+        TEST_ASSERT_EQ(before.misses, after.misses, "No misses expected");
+        TEST_ASSERT_EQ(resizing, after.resize_in_progress, "Reads should not advance a resize");
+    }
+
+    // Expiry passes carry the migration forward without writes
+    for (int i = 0; i < 100000 && stats.resize_in_progress > 0; i++) {
+        hinotetsu_expire(rdb, 0);
+        if (i % 100 == 0) hinotetsu_stats(rdb, &stats);
+    }
+    TEST_ASSERT_EQ(0, stats.resize_in_progress, "Expiry should finish the resize");
+    TEST_ASSERT_EQ((size_t)num_keys, stats.count, "All keys should survive the resize");
+
+    hinotetsu_flush(rdb);
+    hinotetsu_stats(rdb, &stats);
+    hinotetsu_close(rdb);
+    TEST_ASSERT_EQ(0, stats.hits, "Flush should reset the hit counters");
+
+    TEST_PASS();
+}
+
 // Test: Delete stress
 int test_delete_stress(void) {
     TEST_START("delete_stress");
@@ -239,6 +336,249 @@ int test_delete_stress(void) {
     TEST_PASS();
 }
 
+// Test: Sliding window of inserts and deletes. Tombstones are purged by a
+// same-size rehash (or never created), so the table does not grow.
+int test_delete_churn(void) {
+    TEST_START("delete_churn");
+
+    const int WINDOW = 20000;
+    const int TOTAL = 1000000;
+    char key[32];
+    char buf[32];
+
+    hinotetsu_flush(db);
+
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+    hinotetsu_table_stats(db, ts);
+    uint64_t cap_before = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) cap_before += ts->shards[i].capacity;
+
+    for (int i = 0; i < TOTAL; i++) {
+        snprintf(key, sizeof(key), "churn_%d", i);
+        int ret = hinotetsu_set(db, key, strlen(key), key, strlen(key), 0);
+        TEST_ASSERT_EQ(HINOTETSU_OK, ret, "SET should return OK");
+        if (i >= WINDOW) {
+            snprintf(key, sizeof(key), "churn_%d", i - WINDOW);
+            ret = hinotetsu_delete(db, key, strlen(key));
+            TEST_ASSERT_EQ(HINOTETSU_OK, ret, "DELETE should return OK");
+        }
+    }
+
+    HinotetsuStats stats;
+    hinotetsu_stats(db, &stats);
+    TEST_ASSERT_EQ(WINDOW, stats.count, "Only the window should remain");
+
+    hinotetsu_table_stats(db, ts);
+    uint64_t cap_after = 0, tombstones = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+        cap_after += ts->shards[i].capacity;
+        tombstones += ts->shards[i].tombstones;
+    }
+    free(ts);
+    printf("  capacity: %llu -> %llu slots, tombstones: %llu\n",
+           (unsigned long long)cap_before, (unsigned long long)cap_after,
+           (unsigned long long)tombstones);
+    TEST_ASSERT_EQ(cap_before, cap_after, "Churn at a constant live count should not grow");
+#if HINOTETSU_TABLE == HINOTETSU_TABLE_ROBINHOOD
+    TEST_ASSERT_EQ(0, tombstones, "Robin Hood deletes leave no tombstones");
+#endif
+
+    for (int i = 0; i < TOTAL; i += 7) {
+        snprintf(key, sizeof(key), "churn_%d", i);
+        size_t len = 0;
+        int ret = hinotetsu_get_into(db, key, strlen(key), buf, sizeof(buf), &len);
+        if (i >= TOTAL - WINDOW) {
+            TEST_ASSERT_EQ(HINOTETSU_OK, ret, "Key in window should be found");
+            TEST_ASSERT_EQ(strlen(key), len, "Value length should match");
+        } else {
+            TEST_ASSERT_EQ(HINOTETSU_ERR_NOTFOUND, ret, "Deleted key should be gone");
+        }
+    }
+
+    TEST_PASS();
+}
+
+// Test: Tables grown by a burst of keys shrink back once the keys are gone
+int test_table_shrink(void) {
+    TEST_START("table_shrink");
+
+    const int NUM_KEYS = 1000000;
+    char key[32];
+
+    hinotetsu_flush(db);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        snprintf(key, sizeof(key), "shrink_%d", i);
+        hinotetsu_set(db, key, strlen(key), "v", 1, 0);
+    }
+
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+    hinotetsu_table_stats(db, ts);
+    uint64_t cap_full = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) cap_full += ts->shards[i].capacity;
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        snprintf(key, sizeof(key), "shrink_%d", i);
+        hinotetsu_delete(db, key, strlen(key));
+    }
+    // Later writes carry the shrink migration forward
+    for (int i = 0; i < 200000; i++) {
+        snprintf(key, sizeof(key), "after_%d", i);
+        hinotetsu_set(db, key, strlen(key), "v", 1, 0);
+        hinotetsu_delete(db, key, strlen(key));
+    }
+
+    HinotetsuStats stats;
+    hinotetsu_stats(db, &stats);
+    hinotetsu_table_stats(db, ts);
+    uint64_t cap_empty = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) cap_empty += ts->shards[i].capacity;
+    free(ts);
+
+    printf("  capacity: %llu slots full -> %llu slots empty\n",
+           (unsigned long long)cap_full, (unsigned long long)cap_empty);
+
+    TEST_ASSERT(cap_full > (uint64_t)HINOTETSU_SHARDS * HINOTETSU_INIT_CAP, "Tables should have grown");
+    TEST_ASSERT_EQ((uint64_t)HINOTETSU_SHARDS * HINOTETSU_INIT_CAP, cap_empty,
+                   "Tables should shrink back to the initial size");
+    TEST_ASSERT_EQ(0, stats.resize_in_progress, "No shard should still be resizing");
+    TEST_ASSERT_EQ(0, stats.count, "All keys should be gone");
+
+    TEST_PASS();
+}
+
+// Test: Keys that differ only in their last bytes spread over every shard
+int test_shard_spread(void) {
+    TEST_START("shard_spread");
+
+    const int NUM_KEYS = 1000;
+    char key[32];
+
+    hinotetsu_flush(db);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "new:%d", i);
+        hinotetsu_set(db, key, klen, "v", 1, 0);
+    }
+
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+    hinotetsu_table_stats(db, ts);
+    uint32_t used = 0;
+    uint64_t most = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+        if (ts->shards[i].live) used++;
+        if (ts->shards[i].live > most) most = ts->shards[i].live;
+    }
+    free(ts);
+    hinotetsu_flush(db);
+
+    printf("  shards used: %u/%u, most keys in one: %llu\n",
+           used, HINOTETSU_SHARDS, (unsigned long long)most);
+
+    // About 16 keys per shard; 48 would be far outside a fair spread
+    TEST_ASSERT_EQ(HINOTETSU_SHARDS, used, "Every shard should hold keys");
+    TEST_ASSERT(most < 48, "No shard should hold a large share of the keys");
+
+    TEST_PASS();
+}
+
+// Test: Hash table diagnostics (home slots must spread over the whole table)
+int test_table_stats(void) {
+    TEST_START("table_stats");
+
+    const int NUM_KEYS = 150000;
+    char key[32];
+
+    hinotetsu_flush(db);
+    for (int i = 0; i < NUM_KEYS; i++) {
+        snprintf(key, sizeof(key), "tstat_%d", i);
+        hinotetsu_set(db, key, strlen(key), "v", 1, 0);
+    }
+
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+    hinotetsu_table_stats(db, ts);
+
+    uint64_t live = 0, hist = 0, homes = 0, cap = 0;
+    uint32_t max_disp = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+        const HinotetsuTableShardStats* s = &ts->shards[i];
+        live += s->live;
+        cap += s->capacity;
+        homes += s->home_slots;
+        for (uint32_t d = 0; d < HINOTETSU_PROBE_HIST; d++) hist += s->probe_hist[d];
+        if (s->max_displacement > max_disp) max_disp = s->max_displacement;
+    }
+    free(ts);
+
+    printf("  live=%llu home_slots=%llu max_displacement=%u\n",
+           (unsigned long long)live, (unsigned long long)homes, max_disp);
+
+    TEST_ASSERT_EQ(NUM_KEYS, live, "Live entries should match inserted keys");
+    TEST_ASSERT_EQ(live, hist, "Histogram should cover every live entry");
+    // If shard selection shared bits with the table index, at most
+    // 1/HINOTETSU_SHARDS of the home positions could ever be used
+    TEST_ASSERT(homes > cap / HINOTETSU_SHARDS, "Keys should spread over many home slots");
+#if HINOTETSU_TABLE == HINOTETSU_TABLE_CUCKOO
+    TEST_ASSERT(max_disp <= 2, "Cuckoo entries sit in one of two buckets or the stash");
+#endif
+
+    TEST_PASS();
+}
+
+// Test: A table fills up to its layout's load factor before it grows
+int test_table_load(void) {
+    TEST_START("table_load");
+
+#if HINOTETSU_TABLE == HINOTETSU_TABLE_CUCKOO
+    const double LOAD = 0.95;
+#elif HINOTETSU_TABLE == HINOTETSU_TABLE_ROBINHOOD
+    const double LOAD = 0.9;
+#elif HINOTETSU_TABLE == HINOTETSU_TABLE_SWISS
+    const double LOAD = 0.875;
+#else
+    const double LOAD = 0.7;
+#endif
+    char key[32];
+
+    Hinotetsu* h = hinotetsu_open(256 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should succeed");
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+
+    // Highest load of any shard before the first one starts to grow
+    double best = 0.0;
+    int num_keys = 0, resizing = 0;
+    while (!resizing && num_keys < 4000000) {
+        for (int i = 0; i < 500; i++, num_keys++) {
+            int klen = snprintf(key, sizeof(key), "load_%d", num_keys);
+            TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(h, key, klen, "v", 1, 0), "SET should succeed");
+        }
+        hinotetsu_table_stats(h, ts);
+        for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+            if (ts->shards[i].resizing) {
+                resizing = 1;
+                continue;
+            }
+            double load = (double)ts->shards[i].live / ts->shards[i].capacity;
+            if (!resizing && load > best) best = load;
+        }
+    }
+    free(ts);
+
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+
+    printf("  first resize after %d keys, highest load %.3f\n", num_keys, best);
+    TEST_ASSERT(resizing, "Some shard should grow");
+    TEST_ASSERT((size_t)num_keys == stats.count, "Every key should be stored");
+    TEST_ASSERT(best > LOAD - 0.02, "Tables should fill close to their load factor");
+
+    TEST_PASS();
+}
+
 // Test: Value size variations
 int test_value_sizes(void) {
     TEST_START("value_sizes");
@@ -309,6 +649,1270 @@ int test_key_patterns(void) {
     TEST_PASS();
 }
 
+// Test: Eviction keeps a full cache writable
+int test_eviction(void) {
+    TEST_START("eviction");
+
+    const int NUM_KEYS = 600000;
+    char key[32];
+    char value[100];
+    memset(value, 'e', sizeof(value));
+
+    // 64MB holds about 380K entries of this size
+    Hinotetsu* small = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(small != NULL, "hinotetsu_open should return non-NULL");
+
+    int set_ret = HINOTETSU_OK;
+    for (int i = 0; i < NUM_KEYS && set_ret == HINOTETSU_OK; i++) {
+        snprintf(key, sizeof(key), "evict_key_%d", i);
+        set_ret = hinotetsu_set(small, key, strlen(key), value, sizeof(value), 0);
+    }
+
+    HinotetsuStats stats;
+    hinotetsu_stats(small, &stats);
+    printf("  Live keys: %zu, evictions: %zu\n", stats.count, stats.evictions);
+
+    // The most recent key must survive
+    char buf[128];
+    size_t len = 0;
+    int ret = hinotetsu_get_into(small, key, strlen(key), buf, sizeof(buf), &len);
+
+#if HINOTETSU_EVICTION == HINOTETSU_EVICT_NONE
+    // A full cache without eviction rejects an overwrite of a stored key
+    // but keeps its old value
+    char big[2000];
+    memset(big, 'B', sizeof(big));
+    int klen = snprintf(key, sizeof(key), "evict_key_%d", 0);
+    int over_ret = hinotetsu_set(small, key, klen, big, sizeof(big), 0);
+    int kept_ret = hinotetsu_get_into(small, key, klen, buf, sizeof(buf), &len);
+    hinotetsu_close(small);
+
+    (void)ret;
+    TEST_ASSERT_EQ(HINOTETSU_ERR_NOMEM, set_ret, "SET should fail once the cache is full");
+    TEST_ASSERT_EQ(0, stats.evictions, "Nothing should be evicted");
+    TEST_ASSERT_EQ(HINOTETSU_ERR_NOMEM, over_ret, "Overwrite should fail once the cache is full");
+    TEST_ASSERT_EQ(HINOTETSU_OK, kept_ret, "Failed overwrite should keep the old value");
+    TEST_ASSERT_EQ(sizeof(value), len, "Old value length should be unchanged");
+#else
+    hinotetsu_close(small);
+
+    TEST_ASSERT_EQ(HINOTETSU_OK, set_ret, "SET should evict instead of failing");
+    TEST_ASSERT(stats.evictions > 0, "Evictions should be counted");
+    TEST_ASSERT_EQ(NUM_KEYS, stats.count + stats.evictions, "Every key is either live or evicted");
+    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "Most recent key should be readable");
+#endif
+
+    TEST_PASS();
+}
+
+// Test: A cache full of one value size still stores other sizes, new keys
+// and overwrites alike
+int test_eviction_new_size(void) {
+    TEST_START("eviction_new_size");
+
+    const int NUM_FILL = 256 * 1024;
+    const int NUM_NEW = 1000;
+    const size_t sizes[] = {1000, 8000, 100000};
+    static char value[100000];
+    memset(value, 'v', sizeof(value));
+    char key[32];
+
+    Hinotetsu* small = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(small != NULL, "hinotetsu_open should return non-NULL");
+
+    for (int i = 0; i < NUM_FILL; i++) {
+        int klen = snprintf(key, sizeof(key), "fill:%d", i);
+        hinotetsu_set(small, key, klen, value, 200, 0);
+    }
+
+    // Half the keys are new, half overwrite values of the fill size
+    int failed = 0, unreadable = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (int i = 0; i < NUM_NEW; i++) {
+            int klen = i % 2 ? snprintf(key, sizeof(key), "new%zu:%d", sizes[s], i)
+                             : snprintf(key, sizeof(key), "fill:%d", NUM_FILL - 1 - i);
+            if (hinotetsu_set(small, key, klen, value, sizes[s], 0) != HINOTETSU_OK) {
+                failed++;
+                continue;
+            }
+            char probe[1];
+            size_t len = 0;
+            int ret = hinotetsu_get_into(small, key, klen, probe, sizeof(probe), &len);
+            if (ret != HINOTETSU_ERR_TOOSMALL || len != sizes[s]) unreadable++;
+        }
+    }
+
+    HinotetsuStats stats;
+    hinotetsu_stats(small, &stats);
+    printf("  Failed SETs: %d/%d, evictions: %zu\n", failed, 3 * NUM_NEW, stats.evictions);
+    hinotetsu_close(small);
+
+#if HINOTETSU_EVICTION == HINOTETSU_EVICT_NONE
+    TEST_ASSERT(failed > 0, "SETs of a new size should fail once the cache is full");
+    TEST_ASSERT_EQ(0, stats.evictions, "Nothing should be evicted");
+#else
+    TEST_ASSERT_EQ(0, failed, "SETs of a new size should evict instead of failing");
+    TEST_ASSERT_EQ(0, unreadable, "Each value should be readable right after its SET");
+#endif
+
+    TEST_PASS();
+}
+
+// Slab class with the most chunks in use
+static uint32_t busiest_slab_class(Hinotetsu* h) {
+    HinotetsuSlabStats st;
+    hinotetsu_slab_stats(h, &st);
+    uint32_t best = 0;
+    for (uint32_t c = 1; c < st.classes; c++) {
+        if (st.cls[c].used_chunks > st.cls[best].used_chunks) best = c;
+    }
+    return best;
+}
+
+// Test: Reassigning slab pages keeps live entries intact
+int test_slab_reassign(void) {
+    TEST_START("slab_reassign");
+
+    const int NUM_KEYS = 64 * 3000;
+    char key[32];
+    char value[40];
+    char buf[64];
+
+    Hinotetsu* h = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    // Spread entries over several pages per shard, then thin them out so
+    // the pages are mostly free but still hold live entries
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "mv:%d", i);
+        memset(value, 'a' + i % 26, sizeof(value));
+        hinotetsu_set(h, key, klen, value, sizeof(value), i % 3 == 0 ? 3600 : 0);
+    }
+    for (int i = 0; i < NUM_KEYS; i++) {
+        if (i % 10 == 0) continue;
+        int klen = snprintf(key, sizeof(key), "mv:%d", i);
+        hinotetsu_delete(h, key, klen);
+    }
+
+    uint32_t src = busiest_slab_class(h);
+    uint32_t dst = src == 0 ? 1 : 0;
+    HinotetsuSlabStats before, after;
+    HinotetsuStats stats_before, stats_after;
+    hinotetsu_slab_stats(h, &before);
+    hinotetsu_stats(h, &stats_before);
+
+    size_t moved = hinotetsu_slab_reassign(h, (int)src, dst);
+    hinotetsu_slab_stats(h, &after);
+    hinotetsu_stats(h, &stats_after);
+    printf("  Moved %zu pages from chunk size %u to %u\n",
+           moved, before.cls[src].chunk_size, before.cls[dst].chunk_size);
+
+    int bad = 0;
+    for (int i = 0; i < NUM_KEYS; i += 10) {
+        int klen = snprintf(key, sizeof(key), "mv:%d", i);
+        size_t len = 0;
+        memset(value, 'a' + i % 26, sizeof(value));
+        if (hinotetsu_get_into(h, key, klen, buf, sizeof(buf), &len) != HINOTETSU_OK ||
+            len != sizeof(value) || memcmp(buf, value, len) != 0) bad++;
+    }
+
+    // Deleting the moved entries unlinks them from the queues and the wheel
+    for (int i = 0; i < NUM_KEYS; i += 10) {
+        int klen = snprintf(key, sizeof(key), "mv:%d", i);
+        hinotetsu_delete(h, key, klen);
+    }
+    HinotetsuSlabStats empty;
+    hinotetsu_slab_stats(h, &empty);
+    hinotetsu_close(h);
+
+    TEST_ASSERT(moved > 0, "Mostly free pages should be reassigned");
+    TEST_ASSERT_EQ(before.cls[src].total_pages - moved, after.cls[src].total_pages, "Source class should lose pages");
+    TEST_ASSERT_EQ(before.cls[dst].total_pages + moved, after.cls[dst].total_pages, "Target class should gain pages");
+    TEST_ASSERT_EQ(before.cls[src].used_chunks, after.cls[src].used_chunks, "Live entries should be relocated");
+    TEST_ASSERT_EQ(before.cls[src].requested_bytes, after.cls[src].requested_bytes, "Requested bytes should follow the entries");
+    TEST_ASSERT_EQ(stats_before.evictions, stats_after.evictions, "Nothing should be evicted");
+    TEST_ASSERT_EQ(stats_before.item_bytes, stats_after.item_bytes, "Item bytes should not change");
+    TEST_ASSERT_EQ(0, bad, "Relocated entries should read back intact");
+    TEST_ASSERT_EQ(0, empty.cls[src].used_chunks, "All chunks should be free after deletes");
+
+    TEST_PASS();
+}
+
+// Test: Automove feeds a class that starves after the size mix shifts
+int test_slab_automove(void) {
+    TEST_START("slab_automove");
+
+    const int NUM_SMALL = 1000000;
+    const int NUM_LARGE = 4000;
+    char key[32];
+    char small_value[32];
+    char large_value[1000];
+    memset(small_value, 's', sizeof(small_value));
+    memset(large_value, 'L', sizeof(large_value));
+
+    Hinotetsu* h = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    // Small values take every page, then go away
+    for (int i = 0; i < NUM_SMALL; i++) {
+        int klen = snprintf(key, sizeof(key), "small:%d", i);
+        hinotetsu_set(h, key, klen, small_value, sizeof(small_value), 0);
+    }
+    for (int i = 0; i < NUM_SMALL; i++) {
+        int klen = snprintf(key, sizeof(key), "small:%d", i);
+        hinotetsu_delete(h, key, klen);
+    }
+
+    // Large values find their class and the pool dry, and take the pages
+    // the small values left
+    int failed = 0;
+    for (int i = 0; i < NUM_LARGE; i++) {
+        int klen = snprintf(key, sizeof(key), "large:%d", i);
+        if (hinotetsu_set(h, key, klen, large_value, sizeof(large_value), 0) != HINOTETSU_OK) failed++;
+    }
+    printf("  Large SETs failing: %d/%d\n", failed, NUM_LARGE);
+
+    // Rewrite the missing values after each pass; writes that find the
+    // class dry or evict within it keep it marked as starving
+    size_t moved = 0;
+    int stored = 0;
+    for (int round = 0; round < 16 && stored < NUM_LARGE; round++) {
+        moved += hinotetsu_slab_automove(h);
+        for (int i = 0; i < NUM_LARGE; i++) {
+            int klen = snprintf(key, sizeof(key), "large:%d", i);
+            char probe[1];
+            size_t len = 0;
+            if (hinotetsu_get_into(h, key, klen, probe, sizeof(probe), &len) == HINOTETSU_ERR_NOTFOUND) {
+                hinotetsu_set(h, key, klen, large_value, sizeof(large_value), 0);
+            }
+        }
+        HinotetsuStats st;
+        hinotetsu_stats(h, &st);
+        stored = (int)st.count;
+    }
+    printf("  Pages moved: %zu, large values stored: %d/%d\n", moved, stored, NUM_LARGE);
+
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+
+    TEST_ASSERT_EQ(0, failed, "Large SETs should take pages of the emptied class");
+    TEST_ASSERT_EQ(NUM_LARGE, stored, "Every large value should fit after automove");
+    TEST_ASSERT_EQ(NUM_LARGE, stats.count, "Only the large values should be live");
+
+    TEST_PASS();
+}
+
+// Test: Automove follows a shift in the value size mix once the cache is
+// full, when no page is mostly free
+int test_slab_automove_full(void) {
+    TEST_START("slab_automove_full");
+
+    const int NUM_FILL = 256 * 1024;
+    const int NUM_NEW = 1000;
+    char key[32];
+    char fill_value[200];
+    char new_value[1000];
+    memset(fill_value, 'f', sizeof(fill_value));
+    memset(new_value, 'N', sizeof(new_value));
+
+    Hinotetsu* h = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    // One value size takes every page and keeps them busy
+    for (int i = 0; i < NUM_FILL; i++) {
+        int klen = snprintf(key, sizeof(key), "fill:%d", i);
+        hinotetsu_set(h, key, klen, fill_value, sizeof(fill_value), 0);
+    }
+
+    // The fill kept its own class starving; that is no news to automove
+    hinotetsu_slab_automove(h);
+
+    // Store values of another size, rewriting the missing ones after
+    // each pass
+    size_t moved = 0;
+    int stored = 0;
+    for (int round = 0; round < 16 && stored < NUM_NEW; round++) {
+        stored = 0;
+        for (int i = 0; i < NUM_NEW; i++) {
+            int klen = snprintf(key, sizeof(key), "new:%d", i);
+            char probe[1];
+            size_t len = 0;
+            if (hinotetsu_get_into(h, key, klen, probe, sizeof(probe), &len) != HINOTETSU_ERR_NOTFOUND ||
+                hinotetsu_set(h, key, klen, new_value, sizeof(new_value), 0) == HINOTETSU_OK) stored++;
+        }
+        moved += hinotetsu_slab_automove(h);
+    }
+
+    int bad = 0;
+    char buf[sizeof(new_value)];
+    for (int i = 0; i < NUM_NEW; i++) {
+        int klen = snprintf(key, sizeof(key), "new:%d", i);
+        size_t len = 0;
+        if (hinotetsu_get_into(h, key, klen, buf, sizeof(buf), &len) != HINOTETSU_OK ||
+            len != sizeof(new_value) || memcmp(buf, new_value, len) != 0) bad++;
+    }
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    printf("  Pages moved: %zu, new values stored: %d/%d, evictions: %zu\n",
+           moved, NUM_NEW - bad, NUM_NEW, stats.evictions);
+    hinotetsu_close(h);
+
+#if HINOTETSU_EVICTION == HINOTETSU_EVICT_NONE
+    TEST_ASSERT(bad > 0, "Busy pages should not be taken without eviction");
+    TEST_ASSERT_EQ(0, stats.evictions, "Nothing should be evicted");
+#else
+    TEST_ASSERT(moved > 0, "Automove should take busy pages once none is mostly free");
+    TEST_ASSERT_EQ(0, bad, "Every new value should fit after automove");
+#endif
+
+    TEST_PASS();
+}
+
+// Test: Large values can be overwritten and deleted without leaking the pool
+int test_large_values(void) {
+    TEST_START("large_values");
+
+    const int ROUNDS = 20000;
+    const int NUM_KEYS = 256;
+    const size_t MAX_VLEN = 48 * 1024;
+    char key[32];
+    char* value = malloc(MAX_VLEN);
+    char* out = malloc(MAX_VLEN);
+    TEST_ASSERT(value != NULL && out != NULL, "malloc should succeed");
+
+    // 64MB gives each shard 1MB: far less than the bytes written below
+    Hinotetsu* h = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    // One key overwritten with 10KB values
+    int failed = 0;
+    for (int i = 0; i < ROUNDS; i++) {
+        memset(value, 'a' + i % 26, 10 * 1024);
+        if (hinotetsu_set(h, "large:one", 9, value, 10 * 1024, 0) != HINOTETSU_OK) failed++;
+    }
+    size_t len = 0;
+    int ret = hinotetsu_get_into(h, "large:one", 9, out, MAX_VLEN, &len);
+    int intact = ret == HINOTETSU_OK && len == 10 * 1024 && memcmp(out, value, len) == 0;
+
+    // Many keys overwritten with mixed sizes, so extents split and merge
+    unsigned seed = 12345;
+    for (int i = 0; i < ROUNDS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        int k = (int)(seed >> 8) % NUM_KEYS;
+        size_t vlen = 4097 + (size_t)(seed >> 4) % (MAX_VLEN - 4097);
+        int klen = snprintf(key, sizeof(key), "large:%d", k);
+        memset(value, 'A' + k % 26, vlen);
+        if (hinotetsu_set(h, key, klen, value, vlen, 0) != HINOTETSU_OK) failed++;
+    }
+
+    int bad = 0;
+    for (int k = 0; k < NUM_KEYS; k++) {
+        int klen = snprintf(key, sizeof(key), "large:%d", k);
+        if (hinotetsu_get_into(h, key, klen, out, MAX_VLEN, &len) != HINOTETSU_OK) continue;
+        for (size_t j = 0; j < len; j++) {
+            if (out[j] != 'A' + k % 26) { bad++; break; }
+        }
+    }
+
+    HinotetsuSlabStats live;
+    hinotetsu_slab_stats(h, &live);
+
+    // Deleting everything returns every span's pages
+    hinotetsu_delete(h, "large:one", 9);
+    for (int k = 0; k < NUM_KEYS; k++) {
+        int klen = snprintf(key, sizeof(key), "large:%d", k);
+        hinotetsu_delete(h, key, klen);
+    }
+    HinotetsuSlabStats empty;
+    hinotetsu_slab_stats(h, &empty);
+
+    // Past capacity, large SETs evict older large values
+    const int FILL = 2000;
+    int fill_failed = 0;
+    memset(value, 'F', 40 * 1024);
+    for (int i = 0; i < FILL; i++) {
+        int klen = snprintf(key, sizeof(key), "fill:%d", i);
+        if (hinotetsu_set(h, key, klen, value, 40 * 1024, 0) != HINOTETSU_OK) fill_failed++;
+    }
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+    free(value);
+    free(out);
+
+    printf("  Live large items: %llu, span pages: %u, free span bytes: %llu\n",
+           (unsigned long long)live.large_items, live.large_pages,
+           (unsigned long long)live.large_free_bytes);
+
+    TEST_ASSERT_EQ(0, failed, "Large SETs should not exhaust the pool");
+    TEST_ASSERT(intact, "Overwritten large value should read back");
+    TEST_ASSERT_EQ(0, bad, "Large values should read back intact");
+    TEST_ASSERT(live.large_items > 0, "Large items should be counted");
+    TEST_ASSERT_EQ(0, empty.large_items, "No large items after deletes");
+    TEST_ASSERT_EQ(0, empty.large_bytes, "No extent bytes after deletes");
+    TEST_ASSERT_EQ(0, empty.large_requested, "No requested bytes after deletes");
+    TEST_ASSERT_EQ(0, empty.large_pages, "Free spans should return their pages");
+#if HINOTETSU_EVICTION == HINOTETSU_EVICT_NONE
+    TEST_ASSERT(fill_failed > 0, "Large SETs should fail once the pool is full");
+    TEST_ASSERT_EQ(0, stats.evictions, "Nothing should be evicted");
+#else
+    TEST_ASSERT_EQ(0, fill_failed, "Large SETs should evict instead of failing");
+    TEST_ASSERT(stats.evictions > 0, "Large values should be evicted");
+    TEST_ASSERT_EQ(FILL, stats.count + stats.evictions, "Every large value is either live or evicted");
+#endif
+
+    TEST_PASS();
+}
+
+// Test: Shards lease memory from one arena instead of a fixed 1/64 share
+int test_arena_sharing(void) {
+    TEST_START("arena_sharing");
+
+    const int NUM_KEYS = 40;
+    const size_t VLEN = 600 * 1024;
+    const size_t HUGE_VLEN = 4 * 1024 * 1024;
+    char key[32];
+    char* value = malloc(HUGE_VLEN);
+    char* out = malloc(HUGE_VLEN);
+    TEST_ASSERT(value != NULL && out != NULL, "malloc should succeed");
+
+    Hinotetsu* h = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    // One shard can hold far more than 1/64 of the instance
+    memset(value, 'H', HUGE_VLEN);
+    int huge_ret = hinotetsu_set(h, "arena:huge", 10, value, HUGE_VLEN, 0);
+    size_t len = 0;
+    int huge_ok = hinotetsu_get_into(h, "arena:huge", 10, out, HUGE_VLEN, &len) == HINOTETSU_OK &&
+                  len == HUGE_VLEN && memcmp(out, value, len) == 0;
+    HinotetsuStats with_huge, without_huge;
+    hinotetsu_stats(h, &with_huge);
+
+    // Its chunks go back to the arena once it is deleted
+    hinotetsu_delete(h, "arena:huge", 10);
+    hinotetsu_stats(h, &without_huge);
+
+    // A 1MB-per-shard split would evict wherever two of these land on one
+    // shard; the arena only runs out at the instance limit
+    int failed = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "arena:%d", i);
+        memset(value, 'a' + i % 26, VLEN);
+        if (hinotetsu_set(h, key, klen, value, VLEN, 0) != HINOTETSU_OK) failed++;
+    }
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+
+    int bad = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "arena:%d", i);
+        if (hinotetsu_get_into(h, key, klen, out, HUGE_VLEN, &len) != HINOTETSU_OK ||
+            len != VLEN || out[0] != 'a' + i % 26 || out[VLEN - 1] != 'a' + i % 26) bad++;
+    }
+    hinotetsu_close(h);
+    free(value);
+    free(out);
+
+    printf("  Leased: %zu bytes with the 4MB value, %zu after deleting it, %zu with %d x 600KB\n",
+           with_huge.memory_used, without_huge.memory_used, stats.memory_used, NUM_KEYS);
+
+    TEST_ASSERT_EQ(HINOTETSU_OK, huge_ret, "A 4MB value should fit");
+    TEST_ASSERT(huge_ok, "4MB value should read back intact");
+    TEST_ASSERT(without_huge.memory_used + 4 * HINOTETSU_ARENA_CHUNK <= with_huge.memory_used,
+                "Deleting should return chunks to the arena");
+    TEST_ASSERT_EQ(0, failed, "SETs should succeed");
+    TEST_ASSERT_EQ(0, stats.evictions, "Nothing should be evicted below the instance limit");
+    TEST_ASSERT_EQ(0, bad, "Values should read back intact");
+
+    TEST_PASS();
+}
+
+// Test: Once the arena is spent, a shard that needs memory takes chunks
+// back from the others, whichever shards the keys hash to
+int test_arena_pressure(void) {
+    TEST_START("arena_pressure");
+
+    const int NUM_KEYS = 2000;
+    const size_t VLEN = 600 * 1024;
+    char key[32];
+    char* value = malloc(VLEN);
+    char* out = malloc(VLEN);
+    TEST_ASSERT(value != NULL && out != NULL, "malloc should succeed");
+
+    // Each value takes a chunk of its own: 64 fit at a time
+    Hinotetsu* h = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    int failed = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "pressure:%d", i);
+        memset(value, 'a' + i % 26, VLEN);
+        if (hinotetsu_set(h, key, klen, value, VLEN, 0) != HINOTETSU_OK) failed++;
+    }
+
+    // The latest value is always there
+    size_t len = 0;
+    int klen = snprintf(key, sizeof(key), "pressure:%d", NUM_KEYS - 1);
+    int last_ok = hinotetsu_get_into(h, key, klen, out, VLEN, &len) == HINOTETSU_OK &&
+                  len == VLEN && out[0] == 'a' + (NUM_KEYS - 1) % 26;
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+    free(value);
+    free(out);
+
+    printf("  %zu live, %zu evicted\n", stats.count, stats.evictions);
+
+#if HINOTETSU_EVICTION != HINOTETSU_EVICT_NONE
+    TEST_ASSERT_EQ(0, failed, "SETs should take memory back from other shards");
+    TEST_ASSERT(last_ok, "The last value should read back");
+    TEST_ASSERT_EQ((size_t)NUM_KEYS, stats.count + stats.evictions,
+                   "Every value is either live or evicted");
+    TEST_ASSERT(stats.count >= 32, "Most chunks should hold a live value");
+#else
+    (void)failed;
+    (void)last_ok;
+    TEST_ASSERT(stats.count >= 32, "Most chunks should hold a live value");
+#endif
+
+    TEST_PASS();
+}
+
+// Test: Parallel and background pre-faulting of the arena
+int test_prefault(void) {
+    TEST_START("prefault");
+
+    const size_t POOL = 512 * 1024 * 1024;
+    const int NUM_KEYS = 20000;
+    char key[32];
+    char value[200];
+    char out[200];
+
+    HinotetsuOptions opt;
+    hinotetsu_options_init(&opt);
+    opt.pool_size = POOL;
+
+    HinotetsuStats one, four, async;
+    Hinotetsu* h = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(h != NULL, "hinotetsu_open_ex should return non-NULL");
+    hinotetsu_stats(h, &one);
+    hinotetsu_close(h);
+
+    opt.prefault_threads = 4;
+    h = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(h != NULL, "Parallel pre-fault open should succeed");
+    hinotetsu_stats(h, &four);
+    hinotetsu_close(h);
+
+    // Serving starts while the arena is still being faulted in; pre-faulting
+    // must not disturb memory that shards already use
+    opt.prefault_async = 1;
+    h = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(h != NULL, "Background pre-fault open should succeed");
+    int failed = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "prefault:%d", i);
+        memset(value, 'a' + i % 26, sizeof(value));
+        if (hinotetsu_set(h, key, klen, value, sizeof(value), 0) != HINOTETSU_OK) failed++;
+    }
+    for (int i = 0; i < 5000; i++) {
+        hinotetsu_stats(h, &async);
+        if (async.prefault_us != 0) break;
+        usleep(1000);
+    }
+    int bad = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "prefault:%d", i);
+        size_t len = 0;
+        if (hinotetsu_get_into(h, key, klen, out, sizeof(out), &len) != HINOTETSU_OK ||
+            len != sizeof(value) || out[0] != 'a' + i % 26 || out[len - 1] != 'a' + i % 26) bad++;
+    }
+    hinotetsu_close(h);
+
+    printf("  Ready in %llu us with 1 thread, %llu us with 4, %llu us in the background "
+           "(arena faulted in after %llu us)\n",
+           (unsigned long long)one.ready_us, (unsigned long long)four.ready_us,
+           (unsigned long long)async.ready_us, (unsigned long long)async.prefault_us);
+
+    TEST_ASSERT(one.prefault_us != 0 && one.prefault_bytes == one.pool_size,
+                "Open should fault in the whole arena");
+    TEST_ASSERT(four.prefault_us != 0 && four.prefault_bytes == four.pool_size,
+                "Parallel open should fault in the whole arena");
+    TEST_ASSERT(async.prefault_us != 0 && async.prefault_bytes == async.pool_size,
+                "Background pre-fault should finish");
+    TEST_ASSERT_EQ(0, failed, "SETs should succeed during pre-faulting");
+    TEST_ASSERT_EQ(0, bad, "Values should read back intact");
+
+    TEST_PASS();
+}
+
+#ifdef __linux__
+static size_t resident_bytes(void) {
+    unsigned long size = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2) resident = 0;
+    fclose(f);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+#endif
+
+// Test: Elastic arena grows on demand and gives memory back
+int test_elastic(void) {
+    TEST_START("elastic");
+
+    const int NUM_KEYS = 100;
+    const size_t VLEN = 600 * 1024;
+    char key[32];
+    char* value = malloc(VLEN);
+    TEST_ASSERT(value != NULL, "malloc should succeed");
+
+    HinotetsuOptions opt;
+    hinotetsu_options_init(&opt);
+    opt.pool_size = 256 * 1024 * 1024;
+    opt.elastic = 1;
+    Hinotetsu* h = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(h != NULL, "Elastic open should succeed");
+
+    HinotetsuStats idle, filled, deleted, flushed;
+    hinotetsu_stats(h, &idle);
+
+    int failed = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "elastic:%d", i);
+        memset(value, 'a' + i % 26, VLEN);
+        if (hinotetsu_set(h, key, klen, value, VLEN, 0) != HINOTETSU_OK) failed++;
+    }
+    hinotetsu_stats(h, &filled);
+#ifdef __linux__
+    size_t rss_filled = resident_bytes();
+#endif
+
+    // Deleting large values idles their chunks
+    for (int i = 0; i < NUM_KEYS / 2; i++) {
+        int klen = snprintf(key, sizeof(key), "elastic:%d", i);
+        hinotetsu_delete(h, key, klen);
+    }
+    hinotetsu_stats(h, &deleted);
+
+    hinotetsu_flush(h);
+    hinotetsu_stats(h, &flushed);
+#ifdef __linux__
+    size_t rss_flushed = resident_bytes();
+#endif
+    hinotetsu_close(h);
+    free(value);
+
+    printf("  Leased: %zu idle, %zu with %d x 600KB, %zu after deleting half, %zu after flush "
+           "(%zu bytes returned to the OS)\n",
+           idle.memory_used, filled.memory_used, NUM_KEYS, deleted.memory_used,
+           flushed.memory_used, flushed.released_bytes);
+
+    TEST_ASSERT_EQ(0, idle.memory_used, "Nothing should be leased before use");
+    TEST_ASSERT_EQ(0, idle.prefault_bytes, "Elastic arenas are not pre-faulted");
+    TEST_ASSERT_EQ(0, failed, "SETs should succeed");
+    TEST_ASSERT(filled.memory_used >= (size_t)NUM_KEYS * VLEN, "Chunks should be leased on demand");
+    TEST_ASSERT(deleted.released_bytes > 0, "Deleted values' chunks should go back to the OS");
+    TEST_ASSERT_EQ(0, flushed.memory_used, "Flush should return every chunk");
+    TEST_ASSERT(flushed.released_bytes >= filled.memory_used, "Flushed chunks should go back to the OS");
+#ifdef __linux__
+    printf("  RSS: %zu with values, %zu after flush\n", rss_filled, rss_flushed);
+    TEST_ASSERT(rss_filled > rss_flushed + (size_t)NUM_KEYS * VLEN / 2, "RSS should drop after flush");
+#endif
+
+    TEST_PASS();
+}
+
+// Thread function for the borrowed reference test: every stored value is
+// one repeated byte, so a torn or recycled value shows up as a mismatch
+typedef struct {
+    Hinotetsu* h;
+    int num_ops;
+    int writer;
+    unsigned seed;
+    int errors;
+} RefThreadArg;
+
+static void* ref_worker(void* arg) {
+    RefThreadArg* ta = (RefThreadArg*)arg;
+    char key[32];
+    char value[300];
+    for (int i = 0; i < ta->num_ops; i++) {
+        int klen = snprintf(key, sizeof(key), "pin:%d", rand_r(&ta->seed) % 1000);
+        if (ta->writer) {
+            size_t vlen = 100 + (size_t)(i % 200);
+            memset(value, 'a' + i % 26, vlen);
+            if (i % 10 == 9) hinotetsu_delete(ta->h, key, klen);
+            else hinotetsu_set(ta->h, key, klen, value, vlen, 0);
+            continue;
+        }
+        HinotetsuRef ref;
+        if (hinotetsu_get_ref(ta->h, key, klen, &ref) != HINOTETSU_OK) continue;
+        for (size_t j = 1; j < ref.vlen; j++) {
+            if (ref.value[j] != ref.value[0]) { ta->errors++; break; }
+        }
+        hinotetsu_ref_release(ta->h, &ref);
+    }
+    return NULL;
+}
+
+// Test: Pinned entries survive eviction and concurrent overwrites
+int test_pinned_refs(void) {
+    TEST_START("pinned_refs");
+
+    const int NUM_PINNED = 100;
+    const int NUM_FILL = 600000;
+    char key[32];
+    char value[200];
+
+    Hinotetsu* h = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    HinotetsuRef refs[100];
+    int pinned = 0;
+    for (int i = 0; i < NUM_PINNED; i++) {
+        int klen = snprintf(key, sizeof(key), "keep:%d", i);
+        memset(value, 'A' + i % 26, sizeof(value));
+        if (hinotetsu_set(h, key, klen, value, sizeof(value), 0) == HINOTETSU_OK &&
+            hinotetsu_get_ref(h, key, klen, &refs[pinned]) == HINOTETSU_OK) pinned++;
+    }
+
+    // Fill far past the limit, so the pinned keys are evicted (unless
+    // eviction is off), and let the slab mover run over their pages
+    for (int i = 0; i < NUM_FILL; i++) {
+        int klen = snprintf(key, sizeof(key), "fill:%d", i);
+        memset(value, 'f', sizeof(value));
+        hinotetsu_set(h, key, klen, value, 64 + (size_t)(i % 136), 0);
+        if (i % 50000 == 0) hinotetsu_slab_automove(h);
+    }
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+
+    int bad = 0;
+    for (int i = 0; i < pinned; i++) {
+        if (refs[i].vlen != sizeof(value)) { bad++; continue; }
+        for (size_t j = 0; j < refs[i].vlen; j++) {
+            if (refs[i].value[j] != 'A' + i % 26) { bad++; break; }
+        }
+        hinotetsu_ref_release(h, &refs[i]);
+    }
+
+    RefThreadArg args[5];
+    pthread_t threads[5];
+    for (int t = 0; t < 5; t++) {
+        args[t].h = h;
+        args[t].num_ops = 100000;
+        args[t].writer = t == 0;
+        args[t].seed = (unsigned)t + 1u;
+        args[t].errors = 0;
+        pthread_create(&threads[t], NULL, ref_worker, &args[t]);
+    }
+    int torn = 0;
+    for (int t = 0; t < 5; t++) {
+        pthread_join(threads[t], NULL);
+        torn += args[t].errors;
+    }
+
+    hinotetsu_flush(h);
+    HinotetsuStats flushed;
+    hinotetsu_stats(h, &flushed);
+    hinotetsu_close(h);
+
+    printf("  %d pinned through %zu evictions, %d torn reads under overwrites\n",
+           pinned, stats.evictions, torn);
+
+    TEST_ASSERT_EQ(NUM_PINNED, pinned, "Every key should be pinned");
+#if HINOTETSU_EVICTION != HINOTETSU_EVICT_NONE
+    TEST_ASSERT(stats.evictions > 0, "Filling should evict");
+#endif
+    TEST_ASSERT_EQ(0, bad, "Pinned values should stay intact");
+    TEST_ASSERT_EQ(0, torn, "Borrowed values should never change");
+    TEST_ASSERT_EQ(0, flushed.item_bytes, "Released entries should all be freed");
+
+    TEST_PASS();
+}
+
+// Thread function for the read/write race test: values are one repeated
+// byte, and keys "stable:N" are never written after the start
+typedef struct {
+    Hinotetsu* h;
+    int num_ops;
+    int writer;
+    unsigned seed;
+    int errors;
+    int lost;
+} RaceArg;
+
+static void* race_worker(void* arg) {
+    RaceArg* ra = (RaceArg*)arg;
+    char key[32];
+    char value[600];
+    size_t len;
+    for (int i = 0; i < ra->num_ops; i++) {
+        int klen;
+        if (ra->writer) {
+            // Every fourth key is new, so the tables keep growing
+            klen = snprintf(key, sizeof(key), "race:%d", i % 4 == 0 ? i : rand_r(&ra->seed) % 2000);
+            size_t vlen = 16 + (size_t)(rand_r(&ra->seed) % 580);
+            memset(value, 'a' + i % 26, vlen);
+            if (i % 8 == 7) hinotetsu_delete(ra->h, key, klen);
+            else hinotetsu_set(ra->h, key, klen, value, vlen, 0);
+            continue;
+        }
+        if (i % 2) {
+            klen = snprintf(key, sizeof(key), "stable:%d", rand_r(&ra->seed) % 100);
+            if (hinotetsu_get_into(ra->h, key, klen, value, sizeof(value), &len) != HINOTETSU_OK ||
+                len != 8 || memcmp(value, "stable!!", 8) != 0) ra->lost++;
+            continue;
+        }
+        klen = snprintf(key, sizeof(key), "race:%d", rand_r(&ra->seed) % 2000);
+        if (hinotetsu_get_into(ra->h, key, klen, value, sizeof(value), &len) != HINOTETSU_OK) continue;
+        for (size_t j = 1; j < len; j++) {
+            if (value[j] != value[0]) { ra->errors++; break; }
+        }
+    }
+    return NULL;
+}
+
+// Test: Reads racing overwrites, deletes and resizes see whole
+// values, and never miss a key that is present
+int test_read_write_race(void) {
+    TEST_START("read_write_race");
+
+    char key[32];
+    Hinotetsu* h = hinotetsu_open(128 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    for (int i = 0; i < 100; i++) {
+        int klen = snprintf(key, sizeof(key), "stable:%d", i);
+        TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(h, key, klen, "stable!!", 8, 0), "SET should succeed");
+    }
+
+    RaceArg args[4];
+    pthread_t threads[4];
+    for (int t = 0; t < 4; t++) {
+        args[t].h = h;
+        args[t].num_ops = t == 0 ? 400000 : 200000;
+        args[t].writer = t == 0;
+        args[t].seed = (unsigned)t + 7u;
+        args[t].errors = 0;
+        args[t].lost = 0;
+        pthread_create(&threads[t], NULL, race_worker, &args[t]);
+    }
+    int torn = 0, lost = 0;
+    for (int t = 0; t < 4; t++) {
+        pthread_join(threads[t], NULL);
+        torn += args[t].errors;
+        lost += args[t].lost;
+    }
+
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    printf("  %zu items, %d torn reads, %d stable keys missed\n",
+           stats.count, torn, lost);
+    TEST_ASSERT_EQ(0, stats.evictions, "Nothing should be evicted");
+
+    hinotetsu_flush(h);
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+
+    TEST_ASSERT_EQ(0, torn, "Values should never be torn or recycled");
+    TEST_ASSERT_EQ(0, lost, "Present keys should never be missed");
+    TEST_ASSERT_EQ(0, stats.item_bytes, "Flush should free everything");
+
+    TEST_PASS();
+}
+
+#define EVICT_RACE_KEYS 12
+
+// Thread function for the eviction race test: readers copy large values,
+// each one byte repeated, while the writer evicts them
+typedef struct {
+    Hinotetsu* h;
+    int* done;
+    char (*keys)[32];
+    unsigned seed;
+    size_t vlen;
+    long reads;
+    int errors;
+} EvictRaceArg;
+
+static void* evict_race_worker(void* arg) {
+    EvictRaceArg* ea = (EvictRaceArg*)arg;
+    char* value = malloc(ea->vlen);
+    size_t len;
+    while (!__atomic_load_n(ea->done, __ATOMIC_ACQUIRE)) {
+        const char* key = ea->keys[rand_r(&ea->seed) % EVICT_RACE_KEYS];
+        if (hinotetsu_get_into(ea->h, key, strlen(key), value, ea->vlen, &len) != HINOTETSU_OK) continue;
+        ea->reads++;
+        if (len != ea->vlen || value[0] < 'a' || value[0] > 'z') {
+            ea->errors++;
+            continue;
+        }
+        for (size_t j = 1; j < len; j++) {
+            if (value[j] != value[0]) { ea->errors++; break; }
+        }
+    }
+    free(value);
+    return NULL;
+}
+
+// Test: Large values evicted from an elastic arena while lock-free readers
+// copy them are never seen discarded or reused
+int test_evict_race(void) {
+    TEST_START("evict_race");
+
+    // Nearly a chunk each, so evicting one empties its chunk
+    const size_t VLEN = 900 * 1024;
+    char keys[EVICT_RACE_KEYS][32];
+    char* value = malloc(VLEN);
+    TEST_ASSERT(value != NULL, "malloc should succeed");
+
+    HinotetsuOptions opt;
+    hinotetsu_options_init(&opt);
+    opt.pool_size = (size_t)HINOTETSU_SHARDS * HINOTETSU_ARENA_CHUNK;
+    opt.elastic = 1;
+    Hinotetsu* h = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(h != NULL, "Elastic open should succeed");
+
+    // Keys of one shard, so each SET evicts one of the values being read
+    // rather than taking a chunk from another shard
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+    int found = 0;
+    uint32_t shard = HINOTETSU_SHARDS;
+    for (int i = 0; found < EVICT_RACE_KEYS && i < 100000; i++) {
+        int klen = snprintf(keys[found], sizeof(keys[found]), "evict:%d", i);
+        hinotetsu_set(h, keys[found], klen, "v", 1, 0);
+        hinotetsu_table_stats(h, ts);
+        uint32_t id = 0;
+        while (id < HINOTETSU_SHARDS && ts->shards[id].live == 0) id++;
+        hinotetsu_delete(h, keys[found], klen);
+        if (shard == HINOTETSU_SHARDS) shard = id;
+        if (id == shard) found++;
+    }
+    free(ts);
+    hinotetsu_flush(h);  // the probes leased chunks all over
+    TEST_ASSERT_EQ(EVICT_RACE_KEYS, found, "Enough keys should share a shard");
+
+    // Fill all but a few chunks, so the shard soon has to evict its own
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    memset(value, 'z', VLEN);
+    for (size_t i = 0; i + 8u < stats.pool_size / HINOTETSU_ARENA_CHUNK; i++) {
+        char fill[32];
+        int klen = snprintf(fill, sizeof(fill), "fill:%zu", i);
+        hinotetsu_set(h, fill, klen, value, VLEN, 0);
+    }
+
+    int done = 0;
+    EvictRaceArg args[8];
+    pthread_t threads[8];
+    for (int t = 0; t < 8; t++) {
+        args[t].h = h;
+        args[t].done = &done;
+        args[t].keys = keys;
+        args[t].seed = (unsigned)t + 11u;
+        args[t].vlen = VLEN;
+        args[t].reads = 0;
+        args[t].errors = 0;
+        pthread_create(&threads[t], NULL, evict_race_worker, &args[t]);
+    }
+
+    // The pool holds fewer values than there are keys, so most sets evict
+    int failed = 0;
+    unsigned seed = 5u;
+    for (int i = 0; i < 2000; i++) {
+        const char* key = keys[rand_r(&seed) % EVICT_RACE_KEYS];
+        memset(value, 'a' + i % 26, VLEN);
+        if (hinotetsu_set(h, key, strlen(key), value, VLEN, 0) != HINOTETSU_OK) failed++;
+    }
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+
+    long reads = 0;
+    int torn = 0;
+    for (int t = 0; t < 8; t++) {
+        pthread_join(threads[t], NULL);
+        reads += args[t].reads;
+        torn += args[t].errors;
+    }
+
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+    free(value);
+
+    printf("  %ld reads over %zu evictions, %d failed sets, %d torn reads\n",
+           reads, stats.evictions, failed, torn);
+
+#if HINOTETSU_EVICTION != HINOTETSU_EVICT_NONE
+    TEST_ASSERT(stats.evictions > 0, "Overfilling should evict");
+    TEST_ASSERT_EQ(0, failed, "Every SET should find room by evicting");
+#endif
+    TEST_ASSERT_EQ(0, torn, "Evicted values should never be read discarded or reused");
+
+    TEST_PASS();
+}
+
+// Thread function for the growth and displacement tests: looks up keys
+// that are never stored, and the first `stable` "stable:%d" keys, which
+// always are, until the writer is done
+typedef struct {
+    Hinotetsu* h;
+    int* done;
+    unsigned seed;
+    int stable;
+    long lookups;
+    int found;
+    int missed;
+} MissArg;
+
+static void* miss_worker(void* arg) {
+    MissArg* ma = (MissArg*)arg;
+    char key[32];
+    char buf[32];
+    size_t len;
+    while (!__atomic_load_n(ma->done, __ATOMIC_ACQUIRE)) {
+        int klen = snprintf(key, sizeof(key), "absent:%d", rand_r(&ma->seed));
+        if (hinotetsu_get_into(ma->h, key, klen, buf, sizeof(buf), &len) != HINOTETSU_ERR_NOTFOUND) ma->found++;
+        ma->lookups++;
+        if (ma->stable) {
+            klen = snprintf(key, sizeof(key), "stable:%d", rand_r(&ma->seed) % ma->stable);
+            if (hinotetsu_get_into(ma->h, key, klen, buf, sizeof(buf), &len) != HINOTETSU_OK) ma->missed++;
+        }
+    }
+    return NULL;
+}
+
+// Test: Lookups that miss while tables grow under them neither hang nor
+// find anything; with HINOTETSU_LOCKFREE_READS they retry such misses
+int test_miss_during_growth(void) {
+    TEST_START("miss_during_growth");
+
+    const int NUM_KEYS = 1500000;
+    char key[32];
+
+    Hinotetsu* h = hinotetsu_open(256 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+
+    int done = 0;
+    MissArg args[2];
+    pthread_t threads[2];
+    for (int t = 0; t < 2; t++) {
+        args[t].h = h;
+        args[t].done = &done;
+        args[t].seed = (unsigned)t + 11u;
+        args[t].stable = 0;
+        args[t].lookups = 0;
+        args[t].found = 0;
+        args[t].missed = 0;
+        pthread_create(&threads[t], NULL, miss_worker, &args[t]);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "grow:%d", i);
+        if (hinotetsu_set(h, key, klen, "v", 1, 0) != HINOTETSU_OK) failed++;
+    }
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+
+    long lookups = 0;
+    int found = 0;
+    for (int t = 0; t < 2; t++) {
+        pthread_join(threads[t], NULL);
+        lookups += args[t].lookups;
+        found += args[t].found;
+    }
+
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+    hinotetsu_table_stats(h, ts);
+    uint64_t cap = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) cap += ts->shards[i].capacity;
+    free(ts);
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+
+    printf("  %ld missing lookups during growth to %llu slots\n", lookups, (unsigned long long)cap);
+    TEST_ASSERT_EQ(0, failed, "Every SET should succeed");
+    TEST_ASSERT_EQ((size_t)NUM_KEYS, stats.count, "Every key should be stored");
+    TEST_ASSERT(cap > (uint64_t)HINOTETSU_SHARDS * HINOTETSU_INIT_CAP, "Tables should have grown");
+    TEST_ASSERT_EQ(0, found, "Keys never stored should not be found");
+
+    TEST_PASS();
+}
+
+// Test: Lookups stay exact while inserts shuffle entries about a nearly
+// full table. With HINOTETSU_TABLE_CUCKOO a kicked entry is briefly in
+// neither bucket; lock-free readers must retry rather than miss it.
+int test_miss_during_displacement(void) {
+    TEST_START("miss_during_displacement");
+
+    // Just under each layout's load factor, where inserts displace the most
+#if HINOTETSU_TABLE == HINOTETSU_TABLE_CUCKOO
+    const double FILL = 0.9;
+#elif HINOTETSU_TABLE == HINOTETSU_TABLE_ROBINHOOD
+    const double FILL = 0.85;
+#elif HINOTETSU_TABLE == HINOTETSU_TABLE_SWISS
+    const double FILL = 0.8;
+#else
+    const double FILL = 0.65;
+#endif
+    const int NUM_STABLE = 20000;
+    const int NUM_KEYS = (int)(HINOTETSU_SHARDS * HINOTETSU_INIT_CAP * FILL) - NUM_STABLE;
+    char key[32];
+
+    Hinotetsu* h = hinotetsu_open(256 * 1024 * 1024);
+    TEST_ASSERT(h != NULL, "hinotetsu_open should return non-NULL");
+    for (int i = 0; i < NUM_STABLE; i++) {
+        int klen = snprintf(key, sizeof(key), "stable:%d", i);
+        TEST_ASSERT_EQ(HINOTETSU_OK, hinotetsu_set(h, key, klen, "s", 1, 0), "SET should succeed");
+    }
+
+    int done = 0;
+    MissArg args[2];
+    pthread_t threads[2];
+    for (int t = 0; t < 2; t++) {
+        args[t].h = h;
+        args[t].done = &done;
+        args[t].seed = (unsigned)t + 23u;
+        args[t].stable = NUM_STABLE;
+        args[t].lookups = 0;
+        args[t].found = 0;
+        args[t].missed = 0;
+        pthread_create(&threads[t], NULL, miss_worker, &args[t]);
+    }
+
+    int failed = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        int klen = snprintf(key, sizeof(key), "fill:%d", i);
+        if (hinotetsu_set(h, key, klen, "v", 1, 0) != HINOTETSU_OK) failed++;
+    }
+    __atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+
+    long lookups = 0;
+    int found = 0, missed = 0;
+    for (int t = 0; t < 2; t++) {
+        pthread_join(threads[t], NULL);
+        lookups += args[t].lookups;
+        found += args[t].found;
+        missed += args[t].missed;
+    }
+
+    HinotetsuTableStats* ts = malloc(sizeof(*ts));
+    TEST_ASSERT(ts != NULL, "malloc should succeed");
+    hinotetsu_table_stats(h, ts);
+    uint64_t displaced = 0;
+    for (uint32_t i = 0; i < HINOTETSU_SHARDS; i++) {
+        for (uint32_t d = 1; d < HINOTETSU_PROBE_HIST; d++) displaced += ts->shards[i].probe_hist[d];
+    }
+    free(ts);
+    hinotetsu_close(h);
+
+    printf("  %ld lookups, %llu entries off their home position\n",
+           lookups, (unsigned long long)displaced);
+    TEST_ASSERT_EQ(0, failed, "Every SET should succeed");
+    TEST_ASSERT(displaced > 0, "Some entries should be displaced");
+    TEST_ASSERT_EQ(0, found, "Keys never stored should not be found");
+    TEST_ASSERT_EQ(0, missed, "Stored keys should always be found");
+
+    TEST_PASS();
+}
+
+// Thread function for the combining test: each thread cycles SETs and
+// DELETEs over keys of its own, so their final state is known
+typedef struct {
+    Hinotetsu* h;
+    int thread_id;
+    int num_ops;
+    int errors;
+} CombineArg;
+
+#define COMBINE_KEYS 64
+
+static void* combine_worker(void* arg) {
+    CombineArg* ca = (CombineArg*)arg;
+    char key[32];
+    char value[32];
+    for (int i = 0; i < ca->num_ops; i++) {
+        int klen = snprintf(key, sizeof(key), "fc:%d:%d", ca->thread_id, i % COMBINE_KEYS);
+        int ret;
+        if ((i / COMBINE_KEYS) % 3 == 2) {
+            ret = hinotetsu_delete(ca->h, key, klen);
+        } else {
+            int vlen = snprintf(value, sizeof(value), "v%d", i);
+            ret = hinotetsu_set(ca->h, key, klen, value, vlen, 0);
+        }
+        if (ret != HINOTETSU_OK) ca->errors++;
+    }
+    return NULL;
+}
+
+// Test: Writes handed between threads by flat combining all take effect
+int test_combining(void) {
+    TEST_START("combining");
+
+    const int NUM_THREADS = 8;
+    const int NUM_OPS = COMBINE_KEYS * 999 + COMBINE_KEYS / 2;
+    char key[32];
+    char value[32];
+    char buf[32];
+
+    HinotetsuOptions opt;
+    hinotetsu_options_init(&opt);
+    opt.pool_size = 64 * 1024 * 1024;
+    opt.combining = 1;
+    Hinotetsu* h = hinotetsu_open_ex(&opt);
+    TEST_ASSERT(h != NULL, "hinotetsu_open_ex should return non-NULL");
+
+    CombineArg args[8];
+    pthread_t threads[8];
+    long long start = current_time_ms();
+    for (int t = 0; t < NUM_THREADS; t++) {
+        args[t].h = h;
+        args[t].thread_id = t;
+        args[t].num_ops = NUM_OPS;
+        args[t].errors = 0;
+        pthread_create(&threads[t], NULL, combine_worker, &args[t]);
+    }
+    int errors = 0;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+        errors += args[t].errors;
+    }
+    long long elapsed = current_time_ms() - start;
+
+    // Half the keys were last set, the other half deleted
+    int wrong = 0;
+    for (int t = 0; t < NUM_THREADS; t++) {
+        for (int k = 0; k < COMBINE_KEYS; k++) {
+            int last = (NUM_OPS - 1 - k) / COMBINE_KEYS * COMBINE_KEYS + k;
+            int klen = snprintf(key, sizeof(key), "fc:%d:%d", t, k);
+            size_t len = 0;
+            int ret = hinotetsu_get_into(h, key, klen, buf, sizeof(buf), &len);
+            if ((last / COMBINE_KEYS) % 3 == 2) {
+                if (ret != HINOTETSU_ERR_NOTFOUND) wrong++;
+                continue;
+            }
+            int vlen = snprintf(value, sizeof(value), "v%d", last);
+            if (ret != HINOTETSU_OK || len != (size_t)vlen || memcmp(buf, value, len) != 0) wrong++;
+        }
+    }
+
+    HinotetsuStats stats;
+    hinotetsu_stats(h, &stats);
+    hinotetsu_close(h);
+
+    int total = NUM_THREADS * NUM_OPS;
+    printf("  %d writes in %lld ms, %zu run by another writer\n", total, elapsed, stats.combined);
+    TEST_ASSERT_EQ(0, errors, "Every write should succeed");
+    TEST_ASSERT_EQ(0, wrong, "Every key should hold its last write");
+    TEST_ASSERT_EQ((size_t)(NUM_THREADS * COMBINE_KEYS / 2), stats.count, "Only the set keys should remain");
+
+    TEST_PASS();
+}
+
 int main(void) {
     printf("Hinotetsu Stress Tests\n");
     printf("========================================\n");
@@ -327,9 +1931,31 @@ int main(void) {
     RUN_TEST(test_read_performance);
     RUN_TEST(test_mixed_workload);
     RUN_TEST(test_concurrent_access);
+    RUN_TEST(test_concurrent_reads);
     RUN_TEST(test_delete_stress);
+    RUN_TEST(test_delete_churn);
+    RUN_TEST(test_shard_spread);
+    RUN_TEST(test_table_stats);
+    RUN_TEST(test_table_load);
+    RUN_TEST(test_table_shrink);
     RUN_TEST(test_value_sizes);
     RUN_TEST(test_key_patterns);
+    RUN_TEST(test_eviction);
+    RUN_TEST(test_eviction_new_size);
+    RUN_TEST(test_slab_reassign);
+    RUN_TEST(test_slab_automove);
+    RUN_TEST(test_slab_automove_full);
+    RUN_TEST(test_large_values);
+    RUN_TEST(test_arena_sharing);
+    RUN_TEST(test_arena_pressure);
+    RUN_TEST(test_prefault);
+    RUN_TEST(test_elastic);
+    RUN_TEST(test_pinned_refs);
+    RUN_TEST(test_read_write_race);
+    RUN_TEST(test_evict_race);
+    RUN_TEST(test_miss_during_growth);
+    RUN_TEST(test_miss_during_displacement);
+    RUN_TEST(test_combining);
 
     hinotetsu_close(db);
 
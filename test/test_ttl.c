@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include "test_helper.h"
 #include "../hinotetsu3.h"
 
@@ -216,6 +217,154 @@ int test_ttl_delete(void) {
     TEST_PASS();
 }
 
+// Test: Expired keys are recycled, so key turnover reaches a steady state
+int test_ttl_reclaim(void) {
+    TEST_START("ttl_reclaim");
+
+    const int NUM_KEYS = 50000;
+    char key[32];
+    char value[600];
+    memset(value, 'r', sizeof(value));
+
+    hinotetsu_flush(db);
+
+    HinotetsuStats first, last;
+    for (int round = 0; round < 3; round++) {
+        if (round > 0) {
+            printf("  Waiting 2 seconds for round %d to expire...\n", round);
+            sleep(2);
+        }
+        for (int i = 0; i < NUM_KEYS; i++) {
+            snprintf(key, sizeof(key), "session_%d_%d", round, i);
+            int ret = hinotetsu_set(db, key, strlen(key), value, sizeof(value), 1);
+            TEST_ASSERT_EQ(HINOTETSU_OK, ret, "SET should return OK");
+        }
+        // Round 0 fills the pool; later rounds must reuse its memory
+        if (round > 0) hinotetsu_stats(db, round == 1 ? &first : &last);
+    }
+
+    printf("  memory: %zu -> %zu bytes, count: %zu, reclaimed: %zu\n",
+           first.memory_used, last.memory_used, last.count, last.reclaimed);
+
+    // Without reuse every round would carve ~57MB of new slab pages
+    TEST_ASSERT(last.memory_used - first.memory_used < first.memory_used / 50,
+                "Pool usage should stay flat");
+    TEST_ASSERT(last.count < (size_t)NUM_KEYS * 2, "Expired rounds should not be counted");
+    TEST_ASSERT(last.reclaimed >= (size_t)NUM_KEYS, "Expired entries should be reclaimed");
+
+    TEST_PASS();
+}
+
+// Test: The maintenance thread frees expired keys without further traffic
+int test_active_expiry(void) {
+    TEST_START("active_expiry");
+
+    const int NUM_TTL = 20000;
+    const int NUM_KEEP = 1000;
+    char key[32];
+    char value[200];
+    memset(value, 'a', sizeof(value));
+
+    hinotetsu_flush(db);
+    for (int i = 0; i < NUM_KEEP; i++) {
+        snprintf(key, sizeof(key), "keep_%d", i);
+        hinotetsu_set(db, key, strlen(key), value, sizeof(value), 0);
+    }
+    HinotetsuStats base;
+    hinotetsu_stats(db, &base);
+
+    for (int i = 0; i < NUM_TTL; i++) {
+        snprintf(key, sizeof(key), "active_%d", i);
+        hinotetsu_set(db, key, strlen(key), value, sizeof(value), 1);
+    }
+    for (int i = 0; i < 10; i++) {
+        snprintf(key, sizeof(key), "later_%d", i);
+        hinotetsu_set(db, key, strlen(key), value, sizeof(value), 1000);
+    }
+
+    int ret = hinotetsu_maintenance_start(db, 50);
+    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "maintenance_start should return OK");
+    printf("  Waiting 3 seconds for active expiry...\n");
+    sleep(3);
+    hinotetsu_maintenance_stop(db);
+
+    HinotetsuStats stats;
+    hinotetsu_stats(db, &stats);
+    printf("  count: %zu, item_bytes: %zu (base %zu), reclaimed: %zu\n",
+           stats.count, stats.item_bytes, base.item_bytes, stats.reclaimed);
+
+    TEST_ASSERT_EQ(NUM_KEEP + 10, stats.count, "Only keys without a due TTL should remain");
+    TEST_ASSERT(stats.reclaimed >= (size_t)NUM_TTL, "Expired keys should be reclaimed");
+    TEST_ASSERT(stats.item_bytes < base.item_bytes * 2, "Item bytes should drop back");
+
+    char buf[16];
+    size_t len = 0;
+    ret = hinotetsu_get_into(db, "later_0", 7, buf, sizeof(buf), &len);
+    TEST_ASSERT_EQ(HINOTETSU_ERR_TOOSMALL, ret, "Long TTL key should still exist");
+
+    TEST_PASS();
+}
+
+// Test: Millisecond TTL against the system clock
+int test_ttl_ms(void) {
+    TEST_START("ttl_ms");
+
+    const char* key = "lock_key";
+    char buf[16];
+    size_t len = 0;
+
+    int ret = hinotetsu_set_ms(db, key, strlen(key), "1", 1, 200);
+    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "SET should return OK");
+    ret = hinotetsu_get_into(db, key, strlen(key), buf, sizeof(buf), &len);
+    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "Key should exist before its TTL");
+
+    usleep(300 * 1000);
+    ret = hinotetsu_get_into(db, key, strlen(key), buf, sizeof(buf), &len);
+    TEST_ASSERT_EQ(HINOTETSU_ERR_NOTFOUND, ret, "Key should expire after 200ms");
+
+    TEST_PASS();
+}
+
+// Test: An externally driven clock decides expiry to the millisecond
+int test_clock_driven(void) {
+    TEST_START("clock_driven");
+
+    Hinotetsu* cdb = hinotetsu_open(64 * 1024 * 1024);
+    TEST_ASSERT(cdb != NULL, "hinotetsu_open should return non-NULL");
+
+    // A minute ahead of the wall clock, on a fixed millisecond offset
+    const uint64_t t0 = ((uint64_t)time(NULL) + 60) * 1000ULL + 123;
+    const char* key = "driven_key";
+    char buf[16];
+    size_t len = 0;
+
+    hinotetsu_clock_set(cdb, t0);
+    hinotetsu_set_ms(cdb, key, strlen(key), "1", 1, 500);
+    hinotetsu_set(cdb, "driven_sec", 10, "1", 1, 2);
+
+    hinotetsu_clock_set(cdb, t0 + 499);
+    int ret = hinotetsu_get_into(cdb, key, strlen(key), buf, sizeof(buf), &len);
+    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "Key should exist at 499ms");
+
+    hinotetsu_clock_set(cdb, t0 + 500);
+    ret = hinotetsu_get_into(cdb, key, strlen(key), buf, sizeof(buf), &len);
+    TEST_ASSERT_EQ(HINOTETSU_ERR_NOTFOUND, ret, "Key should expire at 500ms");
+
+    hinotetsu_clock_set(cdb, t0 + 1999);
+    ret = hinotetsu_get_into(cdb, "driven_sec", 10, buf, sizeof(buf), &len);
+    TEST_ASSERT_EQ(HINOTETSU_OK, ret, "2s key should exist at 1999ms");
+
+    hinotetsu_clock_set(cdb, t0 + 3000);
+    size_t freed = hinotetsu_expire(cdb, 1000);
+    HinotetsuStats stats;
+    hinotetsu_stats(cdb, &stats);
+    TEST_ASSERT_EQ(2, freed, "Both keys should be expired");
+    TEST_ASSERT_EQ(0, stats.count, "Nothing should remain");
+
+    hinotetsu_close(cdb);
+    TEST_PASS();
+}
+
 int main(void) {
     printf("Hinotetsu TTL Tests\n");
     printf("========================================\n");
@@ -237,6 +386,10 @@ int main(void) {
     RUN_TEST(test_ttl_get_into);
     RUN_TEST(test_ttl_large);
     RUN_TEST(test_ttl_delete);
+    RUN_TEST(test_ttl_reclaim);
+    RUN_TEST(test_active_expiry);
+    RUN_TEST(test_ttl_ms);
+    RUN_TEST(test_clock_driven);
 
     hinotetsu_close(db);
 